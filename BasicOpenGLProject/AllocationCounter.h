@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+//=================================================================================================
+// ALLOCATION COUNTER
+//=================================================================================================
+
+// Test hook: AllocationCounter.cpp replaces the global operator new/delete with
+// versions that count calls. Link it into an executable and compare
+// allocationCount() before and after a tick or frame to check that the steady
+// state never touches the heap.
+std::size_t allocationCount();
@@ -0,0 +1,221 @@
+#include "Arena.h"
+#include "Game.h"
+#include "StateHash.h"
+
+#include <algorithm>
+
+Arena::Arena(int columns, int rows, int snakeCount, int foodCount, std::uint64_t seed)
+	: columns(columns), rows(rows), stride(columns + 2), seed(seed), random(seed), aliveCount(0),
+	items(static_cast<std::size_t>(foodCount)), index(static_cast<std::size_t>(columns + 2) * (rows + 2), emptyEntry),
+	freeCells(columns, rows), ticks(0) {
+	for (int i = 0; i < snakeCount; ++i) {
+		const int startY = (2 * i + 1) * rows / (2 * snakeCount);
+		snakes.emplace_back(new Snake(columns / 4, startY, columns, rows, false));
+	}
+	alive.assign(snakes.size(), 0);
+	crashing.assign(snakes.size(), 0);
+	meals.assign(snakes.size(), -1);
+
+	for (int x = -1; x <= columns; ++x) {
+		index[cellIndex(x, -1)] = wallEntry;
+		index[cellIndex(x, rows)] = wallEntry;
+	}
+	for (int y = 0; y < rows; ++y) {
+		index[cellIndex(-1, y)] = wallEntry;
+		index[cellIndex(columns, y)] = wallEntry;
+	}
+	newGame(seed);
+}
+
+void Arena::newGame(std::uint64_t newSeed) {
+	seed = newSeed;
+	random.reseed(newSeed);
+	ticks = 0;
+	for (int y = 0; y < rows; ++y) {
+		for (int x = 0; x < columns; ++x) {
+			index[cellIndex(x, y)] = emptyEntry;
+		}
+	}
+	freeCells.reset();
+
+	for (std::size_t i = 0; i < snakes.size(); ++i) {
+		Snake& snake = *snakes[i];
+		snake.reset();
+		snake.resetPoints();
+		const std::size_t cell = cellIndex(snake.getHead().x, snake.getHead().y);
+		index[cell] = static_cast<std::int32_t>(i + 1);
+		freeCells.take(static_cast<std::uint32_t>(cell));
+		alive[i] = 1;
+		crashing[i] = 0;
+		meals[i] = -1;
+	}
+	aliveCount = snakes.size();
+
+	for (std::size_t item = 0; item < items.size(); ++item) {
+		spawnFood(item);
+	}
+}
+
+// Game::spawnFood() for one item, on a cell with neither a snake nor other
+// food on it.
+void Arena::spawnFood(std::size_t item) {
+	FoodItem& slot = items[item];
+	switch (random.nextBelow(4)) {
+	case 0:
+		slot.food = &slot.apple;
+		break;
+	case 1:
+		slot.food = &slot.orange;
+		break;
+	case 2:
+		slot.food = &slot.grape;
+		break;
+	case 3:
+		slot.food = &slot.banana;
+		break;
+	}
+	int x, y;
+	if (!freeCells.pick(random, [this](int cx, int cy) { return index[cellIndex(cx, cy)] != emptyEntry; }, x, y)) {
+		slot.food = nullptr; // the board is full
+		return;
+	}
+	slot.food->placeAt(x, y);
+	const std::size_t cell = cellIndex(x, y);
+	index[cell] = foodEntry(item);
+	freeCells.take(static_cast<std::uint32_t>(cell));
+}
+
+// Clears the snake's cells from the index. A crashed head is on a cell that
+// belongs to a wall or another snake and is left alone.
+void Arena::removeSnake(std::size_t snake) {
+	const std::int32_t entry = static_cast<std::int32_t>(snake + 1);
+	for (const SnakeSegment& segment : snakes[snake]->getBody()) {
+		const std::size_t cell = cellIndex(segment.x, segment.y);
+		if (index[cell] == entry) {
+			index[cell] = emptyEntry;
+			freeCells.release(static_cast<std::uint32_t>(cell));
+		}
+	}
+	alive[snake] = 0;
+	--aliveCount;
+}
+
+void Arena::update() {
+	if (aliveCount == 0) {
+		return;
+	}
+	++ticks;
+	const std::size_t count = snakes.size();
+
+	// Every tail leaves its cell before any head arrives, so a head may
+	// follow any tail, its own or another snake's.
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!alive[i]) {
+			continue;
+		}
+		Snake& snake = *snakes[i];
+		const SnakeSegment tail = snake.getBody().back();
+		const bool tailLeaves = snake.getPendingGrowth() == 0;
+		snake.move();
+		if (tailLeaves) {
+			const std::size_t cell = cellIndex(tail.x, tail.y);
+			index[cell] = emptyEntry;
+			freeCells.release(static_cast<std::uint32_t>(cell));
+		}
+	}
+
+	// Heads into walls and bodies, before any head is written.
+	for (std::size_t i = 0; i < count; ++i) {
+		if (alive[i]) {
+			const SnakeSegment& head = snakes[i]->getHead();
+			const std::int32_t entry = index[cellIndex(head.x, head.y)];
+			crashing[i] = entry > 0 || entry == wallEntry;
+		}
+	}
+
+	// Write the heads. A head that finds another snake's entry now met that
+	// snake's head on this tick.
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!alive[i] || crashing[i]) {
+			continue;
+		}
+		const SnakeSegment& head = snakes[i]->getHead();
+		const std::size_t cell = cellIndex(head.x, head.y);
+		const std::int32_t entry = index[cell];
+		if (entry > 0) {
+			crashing[i] = 1;
+			crashing[entry - 1] = 1;
+			continue;
+		}
+		if (entry == emptyEntry) {
+			freeCells.take(static_cast<std::uint32_t>(cell));
+		}
+		else {
+			meals[i] = foodEntry(0) - entry; // the food cell was taken already
+		}
+		index[cell] = static_cast<std::int32_t>(i + 1);
+	}
+
+	// Meals, including food under a head to head crash, which is lost. The
+	// new food waits until the crashed snakes are off the board.
+	for (std::size_t i = 0; i < count; ++i) {
+		if (meals[i] >= 0 && !crashing[i]) {
+			items[meals[i]].food->foodEffect(*snakes[i], random);
+		}
+	}
+	for (std::size_t i = 0; i < count; ++i) {
+		if (alive[i] && crashing[i]) {
+			removeSnake(i);
+			crashing[i] = 0;
+		}
+	}
+	for (std::size_t i = 0; i < count; ++i) {
+		if (meals[i] >= 0) {
+			spawnFood(static_cast<std::size_t>(meals[i]));
+			meals[i] = -1;
+		}
+	}
+}
+
+int Arena::getTickInterval() const {
+	return std::min(std::max(snakes[0]->getSpeed(), Game::minTickInterval), Game::maxTickInterval);
+}
+
+std::uint64_t Arena::stateHash() const {
+	std::uint64_t hash = stateHashSeed;
+	hashValue(hash, ticks);
+	hashValue(hash, random.getState());
+	for (std::size_t i = 0; i < snakes.size(); ++i) {
+		const Snake& snake = *snakes[i];
+		hashValue(hash, alive[i]);
+		hashValue(hash, snake.getPoints());
+		hashValue(hash, snake.getSpeed());
+		hashValue(hash, snake.getDirection());
+		hashValue(hash, snake.getRed());
+		hashValue(hash, snake.getGreen());
+		hashValue(hash, snake.getBlue());
+		if (!alive[i]) {
+			continue; // the body is off the board
+		}
+		for (const auto& segment : snake.getBody()) {
+			hashValue(hash, segment.x);
+			hashValue(hash, segment.y);
+		}
+		hashValue(hash, snake.getPendingGrowth());
+		const InputRing& inputs = snake.getInputs();
+		hashValue(hash, inputs.size());
+		for (int j = 0; j < inputs.size(); ++j) {
+			hashValue(hash, inputs[j].direction);
+		}
+	}
+	for (const FoodItem& item : items) {
+		const Food* food = item.food;
+		hashValue(hash, food ? static_cast<int>(food->getKind()) : -1);
+		if (food) {
+			hashValue(hash, food->getX());
+			hashValue(hash, food->getY());
+		}
+	}
+	freeCells.hashOrder(hash);
+	return hash;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FreeCells.h"
+#include "Food.h"
+#include "Random.h"
+#include "Snake.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//=================================================================================================
+// ARENA
+//=================================================================================================
+
+// Several snakes and several pieces of food on one board, for local players
+// against bots and for bot tournaments. Like Game it has no GL dependency
+// and draws every random number from its own seeded Random.
+//
+// Every cell has one entry in a shared index saying what is on it: nothing,
+// the wall border, a segment of snake i or food item j. A tick first moves
+// every tail off the index, then tests each new head against it once and
+// writes the head in, so head to body, head to head and head to food checks
+// cost one lookup per head however long and however many the snakes are.
+// The free cells of the index feed food spawns the same way as in Game.
+//
+// A snake that crashes is taken off the board and stays out until
+// newGame(). Two heads arriving on the same cell both crash, and so does a
+// head entering the cell another head just left.
+class Arena {
+private:
+	// Index entries besides snake i (i + 1) and food j (foodEntry(j)).
+	static const std::int32_t emptyEntry = 0;
+	static const std::int32_t wallEntry = -1;
+	static std::int32_t foodEntry(std::size_t item) { return -2 - static_cast<std::int32_t>(item); }
+
+	// One object of each type per item, as in Game, so eating never
+	// allocates; food points at the one on the board, nullptr if none is.
+	struct FoodItem {
+		Apple apple;
+		Orange orange;
+		Grape grape;
+		Banana banana;
+		Food* food;
+	};
+
+	int columns, rows;
+	int stride; // columns + 2, the index has a border like OccupancyGrid
+	std::uint64_t seed;
+	Random random;
+	std::vector<std::unique_ptr<Snake>> snakes;
+	std::vector<char> alive;
+	std::vector<char> crashing; // crashed on this tick
+	std::vector<std::int32_t> meals; // food item each head reached this tick, or -1
+	std::size_t aliveCount;
+	std::vector<FoodItem> items;
+	std::vector<std::int32_t> index;
+	FreeCells freeCells;
+	long long ticks;
+
+	std::size_t cellIndex(int x, int y) const {
+		return static_cast<std::size_t>(y + 1) * stride + static_cast<std::size_t>(x + 1);
+	}
+	void spawnFood(std::size_t item);
+	void removeSnake(std::size_t snake);
+public:
+	// Snakes start a quarter of the way in, on rows spread evenly over the
+	// board, all heading right, so there can be at most one per row.
+	Arena(int columns, int rows, int snakeCount, int foodCount, std::uint64_t seed = 1);
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// Starts over: every snake back at its start, new food, scores at 0.
+	void newGame(std::uint64_t newSeed);
+	void update();
+
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	std::uint64_t getSeed() const { return seed; }
+	long long getTicks() const { return ticks; }
+	// Milliseconds per tick, set by snake 0 the way Game's is by its snake.
+	int getTickInterval() const;
+
+	std::size_t getSnakeCount() const { return snakes.size(); }
+	Snake& getSnake(std::size_t snake) { return *snakes[snake]; }
+	const Snake& getSnake(std::size_t snake) const { return *snakes[snake]; }
+	bool isAlive(std::size_t snake) const { return alive[snake] != 0; }
+	std::size_t getAliveCount() const { return aliveCount; }
+	bool isOver() const { return aliveCount == 0; }
+
+	std::size_t getFoodCount() const { return items.size(); }
+	// nullptr while the item has no free cell to spawn on.
+	const Food* getFood(std::size_t item) const { return items[item].food; }
+
+	// True for walls and every cell a snake is on, food is not blocked. x and
+	// y may be anywhere from -1 to columns/rows.
+	bool isBlocked(int x, int y) const {
+		const std::int32_t entry = index[cellIndex(x, y)];
+		return entry > 0 || entry == wallEntry;
+	}
+
+	// Hash of everything that affects future ticks, as Game::stateHash().
+	std::uint64_t stateHash() const;
+};
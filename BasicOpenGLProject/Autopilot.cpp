@@ -0,0 +1,299 @@
+#include "Autopilot.h"
+#include "Bot.h"
+#include "Game.h"
+
+#include <algorithm>
+#include <bitset>
+
+static bool testBit(const std::vector<std::uint64_t>& set, std::size_t i) {
+	return (set[i >> 6] >> (i & 63)) & 1u;
+}
+
+static void setBit(std::vector<std::uint64_t>& set, std::size_t i, bool value) {
+	const std::uint64_t mask = std::uint64_t(1) << (i & 63);
+	set[i >> 6] = value ? set[i >> 6] | mask : set[i >> 6] & ~mask;
+}
+
+// Word w of the bitboard moved shift bits towards higher (up) or lower cell
+// indices, words outside the board read as empty.
+static std::uint64_t shiftedUp(const std::vector<std::uint64_t>& set, std::size_t w, std::size_t shift) {
+	const std::size_t words = shift >> 6;
+	const unsigned bits = static_cast<unsigned>(shift & 63);
+	if (w < words) {
+		return 0;
+	}
+	std::uint64_t value = set[w - words] << bits;
+	if (bits != 0 && w > words) {
+		value |= set[w - words - 1] >> (64 - bits);
+	}
+	return value;
+}
+
+static std::uint64_t shiftedDown(const std::vector<std::uint64_t>& set, std::size_t w, std::size_t shift) {
+	const std::size_t words = shift >> 6;
+	const unsigned bits = static_cast<unsigned>(shift & 63);
+	if (w + words >= set.size()) {
+		return 0;
+	}
+	std::uint64_t value = set[w + words] >> bits;
+	if (bits != 0 && w + words + 1 < set.size()) {
+		value |= set[w + words + 1] << (64 - bits);
+	}
+	return value;
+}
+
+void Autopilot::prepare(const OccupancyGrid& occupancy) {
+	const std::size_t words = occupancy.wordCount();
+	if (occupancy.getStride() != stride || passable.size() != words) {
+		stride = occupancy.getStride();
+		wordSpan = static_cast<std::size_t>(stride) / 64 + 1;
+		for (std::vector<std::uint64_t>* set : { &passable, &goals, &visited, &frontier, &next }) {
+			set->assign(words, 0);
+		}
+		dirtyFirst = 1;
+		dirtyLast = 0;
+	}
+
+	// Free cells; the border is always occupied, so the search never leaves
+	// the board, and the bits past the last cell are cleared.
+	const std::uint64_t* occupied = occupancy.words();
+	for (std::size_t w = 0; w < words; ++w) {
+		passable[w] = ~occupied[w];
+	}
+	const std::size_t cells = occupancy.cellCount();
+	if (cells & 63) {
+		passable[words - 1] &= (std::uint64_t(1) << (cells & 63)) - 1;
+	}
+}
+
+void Autopilot::begin(std::size_t start) {
+	for (std::size_t w = dirtyFirst; w <= dirtyLast; ++w) {
+		visited[w] = 0;
+		frontier[w] = 0;
+	}
+	first = start >> 6;
+	last = first;
+	dirtyFirst = first;
+	dirtyLast = last;
+	setBit(visited, start, true);
+	setBit(frontier, start, true);
+}
+
+bool Autopilot::advance() {
+	const std::size_t words = passable.size();
+	const std::size_t shift = static_cast<std::size_t>(stride);
+
+	// Only the rows around the frontier can change.
+	const std::size_t from = first > wordSpan ? first - wordSpan : 0;
+	const std::size_t to = std::min(last + wordSpan, words - 1);
+	for (std::size_t w = from; w <= to; ++w) {
+		const std::uint64_t neighbours = shiftedUp(frontier, w, 1) | shiftedDown(frontier, w, 1)
+			| shiftedUp(frontier, w, shift) | shiftedDown(frontier, w, shift);
+		next[w] = neighbours & passable[w] & ~visited[w];
+	}
+
+	first = words;
+	last = 0;
+	for (std::size_t w = from; w <= to; ++w) {
+		frontier[w] = next[w];
+		visited[w] |= next[w];
+		if (next[w] != 0) {
+			first = std::min(first, w);
+			last = w;
+		}
+	}
+	dirtyFirst = std::min(dirtyFirst, from);
+	dirtyLast = std::max(dirtyLast, to);
+	return first <= last;
+}
+
+bool Autopilot::frontierHasGoal() const {
+	for (std::size_t w = first; w <= last; ++w) {
+		if (frontier[w] & goals[w]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::size_t Autopilot::visitedCount() const {
+	std::size_t count = 0;
+	for (std::size_t w = dirtyFirst; w <= dirtyLast; ++w) {
+		count += std::bitset<64>(visited[w]).count();
+	}
+	return count;
+}
+
+int Autopilot::search(std::size_t start, std::size_t& area) {
+	begin(start);
+	int layer = 0;
+	while (!frontierHasGoal()) {
+		if (!advance()) {
+			area = visitedCount();
+			return -1;
+		}
+		++layer;
+	}
+	area = visitedCount();
+	return layer;
+}
+
+int Autopilot::tailDistance(const Game& game, std::size_t cell, std::size_t& area) {
+	const Snake& snake = game.getSnake();
+	const SegmentRing& body = snake.getBody();
+	const OccupancyGrid& occupancy = snake.getOccupancy();
+
+	// After the step the head is on cell, and unless the snake is growing the
+	// tail has moved up to the segment ahead of it.
+	std::size_t tail = cell;
+	if (snake.getPendingGrowth() > 0) {
+		tail = occupancy.cellIndex(body.back().x, body.back().y);
+	}
+	else if (body.size() > 1) {
+		const SnakeSegment& segment = body[body.size() - 2];
+		tail = occupancy.cellIndex(segment.x, segment.y);
+	}
+
+	const bool cellWasPassable = testBit(passable, cell);
+	const bool tailWasPassable = testBit(passable, tail);
+	setBit(passable, cell, false);
+	setBit(passable, tail, true);
+	setBit(goals, tail, true);
+	const int distance = search(cell, area);
+	setBit(goals, tail, false);
+	setBit(passable, tail, tailWasPassable);
+	setBit(passable, cell, cellWasPassable);
+	return distance;
+}
+
+bool Autopilot::canEscape(const Game& game, std::size_t cell, int growth) {
+	const Snake& snake = game.getSnake();
+	const SegmentRing& body = snake.getBody();
+	const OccupancyGrid& occupancy = snake.getOccupancy();
+	const int length = static_cast<int>(body.size());
+
+	// The head reaches layer t of the search on tick t, and by then segment i
+	// has left its cell if i >= length - t + growth. Thawing those cells as
+	// the search goes finds a path the head can follow without ever waiting;
+	// once it is longer than the body plus its growth the way is clear.
+	begin(cell);
+	int thawed = length; // segments from here to the tail are passable
+	for (int tick = 1; tick < length + growth; ++tick) {
+		const int leaving = length - (tick + 1) + growth;
+		for (; thawed > leaving && thawed > 0; --thawed) {
+			const SnakeSegment& segment = body[static_cast<std::size_t>(thawed - 1)];
+			setBit(passable, occupancy.cellIndex(segment.x, segment.y), true);
+		}
+		if (!advance()) {
+			break;
+		}
+	}
+	const bool escaped = first <= last;
+
+	// Put the body back, the tail only if it was blocked to begin with.
+	const bool tailFree = snake.getPendingGrowth() == 0;
+	for (int i = thawed; i < length; ++i) {
+		if (i == length - 1 && tailFree) {
+			continue;
+		}
+		const SnakeSegment& segment = body[static_cast<std::size_t>(i)];
+		setBit(passable, occupancy.cellIndex(segment.x, segment.y), false);
+	}
+	return escaped;
+}
+
+char Autopilot::decide(const Game& game) {
+	static const char order[] = { 'w', 'a', 's', 'd' };
+	static const char opposite[] = { 's', 'd', 'w', 'a' };
+	const Snake& snake = game.getSnake();
+	const OccupancyGrid& occupancy = snake.getOccupancy();
+	const char current = snake.getDirection();
+	if (occupancy.isPaged()) {
+		return greedyDirection(game); // no bitboard to search on huge boards
+	}
+	prepare(occupancy);
+
+	// Unless the snake is growing its tail moves out of the way this tick, so
+	// stepping onto it is safe.
+	const SnakeSegment head = snake.getHead();
+	const SnakeSegment tail = snake.getBody().back();
+	if (snake.getPendingGrowth() == 0) {
+		setBit(passable, occupancy.cellIndex(tail.x, tail.y), true);
+	}
+
+	const std::size_t headCell = occupancy.cellIndex(head.x, head.y);
+	const std::size_t row = static_cast<std::size_t>(stride);
+	const std::size_t cells[4] = { headCell + row, headCell - 1, headCell - row, headCell + 1 };
+	bool open[4];
+	bool anyOpen = false;
+	for (int i = 0; i < 4; ++i) {
+		open[i] = current != opposite[i] && testBit(passable, cells[i]);
+		anyOpen = anyOpen || open[i];
+	}
+	if (!anyOpen) {
+		return current; // boxed in, every move ends the game
+	}
+
+	// Distance to the food for each move, searched from the food towards the
+	// head. With no food left the corner of the border stands in for it, a
+	// wall cell that is never reachable.
+	const Food* food = game.getFood();
+	const std::size_t foodCell = food ? occupancy.cellIndex(food->getX(), food->getY()) : occupancy.cellIndex(-1, -1);
+	const bool foodReachable = testBit(passable, foodCell);
+	std::size_t area = 0;
+	int foodDistance[4];
+	for (int i = 0; i < 4; ++i) {
+		foodDistance[i] = -1;
+		if (open[i] && foodReachable) {
+			setBit(goals, cells[i], true);
+			foodDistance[i] = search(foodCell, area);
+			setBit(goals, cells[i], false);
+		}
+	}
+
+	// Head for the food along the shortest move that leaves a way out,
+	// checking the nearest moves first.
+	int escape[4] = { -1, -1, -1, -1 }; // unknown until checked
+	auto canEscapeFrom = [&](int i) {
+		if (escape[i] < 0) {
+			const int growth = snake.getPendingGrowth() + (cells[i] == foodCell ? 1 : 0);
+			escape[i] = canEscape(game, cells[i], growth) ? 1 : 0;
+		}
+		return escape[i] == 1;
+	};
+	for (;;) {
+		int nearest = -1;
+		for (int i = 0; i < 4; ++i) {
+			if (foodDistance[i] >= 0 && escape[i] < 0 && (nearest < 0 || foodDistance[i] < foodDistance[nearest])) {
+				nearest = i;
+			}
+		}
+		if (nearest < 0) {
+			break;
+		}
+		if (canEscapeFrom(nearest)) {
+			return order[nearest];
+		}
+	}
+
+	// Otherwise follow the tail the long way round so the body has time to
+	// clear away from the food, preferring moves with a way out and then the
+	// ones with the most room.
+	int best = -1;
+	int bestDistance = -1;
+	std::size_t bestArea = 0;
+	for (int i = 0; i < 4; ++i) {
+		if (!open[i]) {
+			continue;
+		}
+		canEscapeFrom(i);
+		const int distance = tailDistance(game, cells[i], area);
+		if (best < 0 || escape[i] > escape[best]
+			|| (escape[i] == escape[best] && (distance > bestDistance || (distance == bestDistance && area > bestArea)))) {
+			best = i;
+			bestDistance = distance;
+			bestArea = area;
+		}
+	}
+	return order[best];
+}
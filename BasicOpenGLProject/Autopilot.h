@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Game;
+class OccupancyGrid;
+
+//=================================================================================================
+// AUTOPILOT
+//=================================================================================================
+
+// Pathfinding bot. Every decision runs breadth first searches over a bitboard
+// copy of the snake's occupancy grid, advanced a whole layer at a time with
+// shifts and masks, so a decision on the default board takes microseconds.
+//
+// The snake takes the shortest way to the food as long as it can still get
+// out afterwards: a search that lets body cells thaw on the tick the tail
+// leaves them has to outlast the body. Otherwise it follows its own tail the
+// long way round until the food becomes safe to get.
+//
+// The bitboards are sized on the first decision for a board and reused after
+// that, deciding does not allocate. Boards too large for a dense occupancy
+// bitmap fall back to the greedy bot.
+class Autopilot {
+private:
+	int stride;
+	std::size_t wordSpan; // how many words a step of one row can cross
+	std::vector<std::uint64_t> passable, goals, visited, frontier, next;
+	// The frontier is only non-zero between these words, and visited and
+	// frontier only between the dirty ones.
+	std::size_t first, last;
+	std::size_t dirtyFirst, dirtyLast;
+
+	void prepare(const OccupancyGrid& occupancy);
+
+	// Layer by layer breadth first search over passable cells.
+	void begin(std::size_t start);
+	bool advance(); // false once nothing new is reachable
+	bool frontierHasGoal() const;
+	std::size_t visitedCount() const;
+
+	// Search from start until a layer contains a goal. Returns that layer's
+	// number (0 is start itself), or -1 if no goal is reachable. area is the
+	// number of cells visited.
+	int search(std::size_t start, std::size_t& area);
+	// Steps onto cell and searches for where the tail will be. Returns the
+	// tail's distance from there, or -1.
+	int tailDistance(const Game& game, std::size_t cell, std::size_t& area);
+	// Can the head keep moving after stepping onto cell until the whole
+	// current body has left the board?
+	bool canEscape(const Game& game, std::size_t cell, int growth);
+public:
+	Autopilot() : stride(0), wordSpan(0), first(1), last(0), dirtyFirst(1), dirtyLast(0) {}
+
+	// Picks the next direction for the game's snake, one of 'w', 'a', 's', 'd'.
+	char decide(const Game& game);
+};
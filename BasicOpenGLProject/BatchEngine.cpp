@@ -0,0 +1,357 @@
+#include "BatchEngine.h"
+#include "FoodRules.h"
+#include "Random.h"
+#include "Snake.h"
+#include "StateHash.h"
+
+#include <cstdlib>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+const char directionKeys[4] = { 'w', 'a', 's', 'd' };
+
+// The lanes store FoodKind as a number and grow by one segment per meal.
+constexpr bool everyFoodGrowsOne() {
+	for (const FoodRule& rule : foodRules) {
+		if (rule.growth != 1) {
+			return false;
+		}
+	}
+	return true;
+}
+static_assert(everyFoodGrowsOne(), "the batch kernels grow the snake by one segment per meal");
+
+std::int32_t directionIndex(char key) {
+	switch (key) {
+	case 'w': return 0;
+	case 'a': return 1;
+	case 's': return 2;
+	case 'd': return 3;
+	}
+	return -1;
+}
+
+std::size_t roundUp8(std::size_t n) {
+	return (n + 7) & ~std::size_t(7);
+}
+
+// Scalar versions of the kernels in BatchEngineAvx2.cpp, lane by lane.
+void turnAndAdvanceScalar(const BatchEngine::Lanes& v) {
+	static const std::int32_t dx[4] = { 0, -1, 0, 1 };
+	static const std::int32_t dy[4] = { 1, 0, -1, 0 };
+	for (std::size_t i = 0; i < v.count; ++i) {
+		if (!v.active[i]) {
+			continue;
+		}
+		if (v.input[i] >= 0 && v.input[i] != (v.direction[i] ^ 2)) {
+			v.direction[i] = v.input[i];
+		}
+		v.newX[i] = v.headX[i] + dx[v.direction[i]];
+		v.newY[i] = v.headY[i] + dy[v.direction[i]];
+		v.newCell[i] = (v.newY[i] + 1) * v.stride + v.newX[i] + 1;
+	}
+}
+
+void eatScalar(const BatchEngine::Lanes& v) {
+	for (std::size_t i = 0; i < v.count; ++i) {
+		v.ate[i] = v.active[i] && v.newX[i] == v.foodX[i] && v.newY[i] == v.foodY[i] ? -1 : 0;
+		if (v.ate[i]) {
+			const FoodRule& rule = foodRules[v.foodType[i]];
+			v.points[i] += rule.points;
+			v.speed[i] += rule.speedDelta;
+			if (v.length[i] + v.pendingGrowth[i] < v.cells) {
+				++v.pendingGrowth[i];
+			}
+		}
+	}
+}
+
+} // namespace
+
+bool BatchEngine::cpuHasAvx2() {
+#if !defined(SNAKE_HAVE_AVX2)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+BatchEngine::BatchEngine(std::size_t lanes, int columns, int rows)
+	: lanes(lanes), paddedLanes(roundUp8(lanes)), columns(columns), rows(rows), stride(columns + 2), cells(columns * rows),
+	words((static_cast<std::size_t>(columns + 2) * (rows + 2) + 63) / 64), vectorized(cpuHasAvx2()),
+	tickLimit(std::numeric_limits<long long>::max()) {
+	for (auto* field : { &headX, &headY, &direction, &input, &newX, &newY, &newCell, &active, &ate,
+		&length, &pendingGrowth, &points, &speed, &foodX, &foodY, &foodType, &ringHead, &finalLength, &gameOver }) {
+		field->assign(paddedLanes, 0);
+	}
+	ticks.assign(paddedLanes, 0);
+	randomState.assign(paddedLanes, 0);
+	randomIncrement.assign(paddedLanes, 0);
+	red.assign(paddedLanes, 1.0f);
+	green.assign(paddedLanes, 1.0f);
+	blue.assign(paddedLanes, 1.0f);
+	occupancy.assign(paddedLanes * words, 0);
+	body.assign(paddedLanes * static_cast<std::size_t>(cells), 0);
+	freeCells.reserve(lanes);
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		freeCells.emplace_back(columns, rows);
+	}
+
+	border.assign(words, 0);
+	for (int y = -1; y <= rows; ++y) {
+		for (int x = -1; x <= columns; ++x) {
+			if (x < 0 || x >= columns || y < 0 || y >= rows) {
+				const std::int32_t cell = cellIndex(x, y);
+				border[cell >> 6] |= std::uint64_t(1) << (cell & 63);
+			}
+		}
+	}
+
+	// Until reset, every lane is a finished game.
+	for (std::size_t lane = 0; lane < paddedLanes; ++lane) {
+		gameOver[lane] = 1;
+	}
+}
+
+BatchEngine::Lanes BatchEngine::view() {
+	return { paddedLanes, headX.data(), headY.data(), direction.data(), input.data(), newX.data(), newY.data(), newCell.data(),
+		active.data(), ate.data(), length.data(), pendingGrowth.data(), points.data(), speed.data(), foodX.data(), foodY.data(),
+		foodType.data(), stride, cells };
+}
+
+// Snake::reset(): back to one segment in the middle, heading right.
+void BatchEngine::resetSnake(std::size_t lane) {
+	for (std::size_t w = 0; w < words; ++w) {
+		occupancy[lane * words + w] = border[w];
+	}
+	headX[lane] = columns / 2;
+	headY[lane] = rows / 2;
+	ringHead[lane] = 0;
+	body[lane * cells] = cellIndex(headX[lane], headY[lane]);
+	setCell(lane, body[lane * cells]);
+	freeCells[lane].reset();
+	freeCells[lane].take(static_cast<std::uint32_t>(body[lane * cells]));
+	length[lane] = 1;
+	pendingGrowth[lane] = 0;
+	direction[lane] = 3;
+	speed[lane] = Snake::startSpeed;
+	red[lane] = 1.0f;
+	green[lane] = 1.0f;
+	blue[lane] = 1.0f;
+}
+
+// Game::spawnFood()
+void BatchEngine::spawnFood(std::size_t lane) {
+	Random random;
+	random.setState(randomState[lane], randomIncrement[lane]);
+	foodType[lane] = static_cast<std::int32_t>(random.nextBelow(4));
+	int x, y;
+	if (freeCells[lane].pick(random, [&](int cx, int cy) { return testCell(lane, cellIndex(cx, cy)); }, x, y)) {
+		foodX[lane] = x;
+		foodY[lane] = y;
+	}
+	else {
+		// The board is full. A cell no head can reach, so the lane never eats.
+		foodType[lane] = -1;
+		foodX[lane] = -2;
+		foodY[lane] = -2;
+	}
+	randomState[lane] = random.getState();
+}
+
+void BatchEngine::reset(std::size_t lane, std::uint64_t seed) {
+	Random random(seed);
+	randomState[lane] = random.getState();
+	randomIncrement[lane] = random.getIncrement();
+	resetSnake(lane);
+	points[lane] = 0;
+	ticks[lane] = 0;
+	gameOver[lane] = 0;
+	active[lane] = -1;
+	spawnFood(lane);
+}
+
+// Snake::move() and Game::checkCollision() for every playing lane, with the
+// new head cell already worked out by the turn kernel. Counts the lanes that
+// crashed and the lanes that reached the tick limit.
+void BatchEngine::moveBodies(std::size_t& crashes, std::size_t& limits) {
+	crashes = 0;
+	limits = 0;
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		if (!active[lane]) {
+			continue;
+		}
+		++ticks[lane];
+		const std::int32_t lengthBefore = length[lane];
+
+		std::int32_t* ring = &body[lane * cells];
+		if (pendingGrowth[lane] > 0) {
+			--pendingGrowth[lane];
+		}
+		else {
+			std::int32_t tail = ringHead[lane] + length[lane] - 1;
+			if (tail >= cells) {
+				tail -= cells;
+			}
+			clearCell(lane, ring[tail]);
+			freeCells[lane].release(static_cast<std::uint32_t>(ring[tail]));
+			--length[lane];
+		}
+
+		const std::int32_t cell = newCell[lane];
+		const bool crashed = testCell(lane, cell);
+		ringHead[lane] = ringHead[lane] == 0 ? cells - 1 : ringHead[lane] - 1;
+		ring[ringHead[lane]] = cell;
+		++length[lane];
+		headX[lane] = newX[lane];
+		headY[lane] = newY[lane];
+
+		if (crashed) {
+			// Game::handleGameOver(), the crashed head stays off the bitboard.
+			gameOver[lane] = 1;
+			active[lane] = 0;
+			finalLength[lane] = lengthBefore;
+			++crashes;
+		}
+		else {
+			setCell(lane, cell);
+			freeCells[lane].take(static_cast<std::uint32_t>(cell));
+			if (ticks[lane] >= tickLimit) {
+				// The lane still eats this tick, stopLimitedLanes() takes it
+				// out after the meal.
+				finalLength[lane] = length[lane];
+				++limits;
+			}
+		}
+	}
+}
+
+void BatchEngine::stopLimitedLanes() {
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		if (active[lane] && ticks[lane] >= tickLimit) {
+			active[lane] = 0;
+		}
+	}
+}
+
+// The parts of the food effects that draw random numbers, and the new food.
+void BatchEngine::applyMeals() {
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		if (!ate[lane]) {
+			continue;
+		}
+		if (foodRules[foodType[lane]].recolor) {
+			Random random;
+			random.setState(randomState[lane], randomIncrement[lane]);
+			red[lane] = random.nextFloat();
+			green[lane] = random.nextFloat();
+			blue[lane] = random.nextFloat();
+			randomState[lane] = random.getState();
+		}
+		spawnFood(lane);
+	}
+}
+
+std::size_t BatchEngine::step(const char* inputs) {
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		input[lane] = directionIndex(inputs[lane]);
+	}
+
+	const Lanes lanesView = view();
+	std::size_t crashes;
+	std::size_t limits;
+#if defined(SNAKE_HAVE_AVX2)
+	if (vectorized) {
+		batchTurnAndAdvanceAvx2(lanesView);
+		moveBodies(crashes, limits);
+		batchEatAvx2(lanesView);
+	}
+	else
+#endif
+	{
+		turnAndAdvanceScalar(lanesView);
+		moveBodies(crashes, limits);
+		eatScalar(lanesView);
+	}
+
+	applyMeals();
+	if (limits > 0) {
+		stopLimitedLanes();
+	}
+	return crashes + limits;
+}
+
+// greedyDirection() from Bot.cpp on the lane arrays.
+void BatchEngine::greedyInputs(char* inputs) const {
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		if (!active[lane]) {
+			inputs[lane] = 0;
+			continue;
+		}
+
+		static const std::int32_t dx[4] = { 0, -1, 0, 1 };
+		static const std::int32_t dy[4] = { 1, 0, -1, 0 };
+		const std::int32_t current = direction[lane];
+		const bool hasFood = foodType[lane] >= 0;
+		const int targetX = hasFood ? foodX[lane] : headX[lane];
+		const int targetY = hasFood ? foodY[lane] : headY[lane];
+		std::int32_t best = current;
+		int bestScore = -1000000;
+		for (std::int32_t d = 0; d < 4; ++d) {
+			if (d == (current ^ 2)) {
+				continue;
+			}
+			const int x = headX[lane] + dx[d];
+			const int y = headY[lane] + dy[d];
+			int score = -(std::abs(targetX - x) + std::abs(targetY - y));
+			if (testCell(lane, cellIndex(x, y))) {
+				score -= 100000;
+			}
+			if (score > bestScore) {
+				bestScore = score;
+				best = d;
+			}
+		}
+		inputs[lane] = directionKeys[best];
+	}
+}
+
+std::uint64_t BatchEngine::stateHash(std::size_t lane) const {
+	std::uint64_t hash = stateHashSeed;
+	hashValue(hash, ticks[lane]);
+	hashValue(hash, static_cast<bool>(gameOver[lane] != 0));
+	hashValue(hash, randomState[lane]);
+	hashValue(hash, points[lane]);
+	hashValue(hash, speed[lane]);
+	hashValue(hash, directionKeys[direction[lane]]);
+	hashValue(hash, red[lane]);
+	hashValue(hash, green[lane]);
+	hashValue(hash, blue[lane]);
+	const std::int32_t* ring = &body[lane * cells];
+	std::int32_t slot = ringHead[lane];
+	for (std::int32_t i = 0; i < length[lane]; ++i) {
+		hashValue(hash, cellX(ring[slot]));
+		hashValue(hash, cellY(ring[slot]));
+		if (++slot == cells) {
+			slot = 0;
+		}
+	}
+	hashValue(hash, static_cast<int>(pendingGrowth[lane]));
+	hashValue(hash, 0); // no queued turns, a lane takes one input a tick
+	hashValue(hash, static_cast<int>(foodType[lane]));
+	if (foodType[lane] >= 0) {
+		hashValue(hash, static_cast<int>(foodX[lane]));
+		hashValue(hash, static_cast<int>(foodY[lane]));
+	}
+	freeCells[lane].hashOrder(hash);
+	return hash;
+}
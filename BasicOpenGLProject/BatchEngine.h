@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FreeCells.h"
+
+//=================================================================================================
+// BATCH ENGINE
+//=================================================================================================
+
+// Thousands of games advanced in lockstep, stored as structure of arrays: one
+// array per field (head x, head y, direction, length, food cell, ...) indexed
+// by lane, plus per lane occupancy bitboards and body rings. step() advances
+// every lane by one tick; the per lane arithmetic (turning, the new head, the
+// food test and food effects) runs eight lanes at a time with AVX2 when the
+// CPU has it, the bitboard and ring updates are scalar.
+//
+// A lane follows exactly the rules of Game: the same move, deferred grow,
+// collision, food effects and Random sequence, so a lane and a Game started
+// from the same seed and given the same keys end with the same stateHash().
+// The one restriction is at most one key per lane per tick, which is what the
+// bots and the window produce.
+class BatchEngine {
+public:
+	BatchEngine(std::size_t lanes, int columns, int rows);
+
+	std::size_t getLanes() const { return lanes; }
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+
+	// Same as Game::newGame(seed) for one lane.
+	void reset(std::size_t lane, std::uint64_t seed);
+
+	// Takes a lane out of play without ending its game, e.g. when a tick limit
+	// is reached. reset() brings it back.
+	void stop(std::size_t lane) { active[lane] = 0; }
+	bool isPlaying(std::size_t lane) const { return active[lane] != 0; }
+
+	// Lanes stop playing, without their game ending, once they have run this
+	// many ticks.
+	void setTickLimit(long long limit) { tickLimit = limit; }
+
+	// inputs[lane] is 'w', 'a', 's', 'd', or 0 for no key this tick. Lanes that
+	// are not playing are left alone. Returns how many lanes stopped playing
+	// during this tick, through game over or the tick limit.
+	std::size_t step(const char* inputs);
+
+	// Fills inputs with greedyDirection() (see Bot.h) for every lane.
+	void greedyInputs(char* inputs) const;
+
+	bool isGameOver(std::size_t lane) const { return gameOver[lane] != 0; }
+	int getPoints(std::size_t lane) const { return points[lane]; }
+	int getSpeed(std::size_t lane) const { return speed[lane]; }
+	long long getTicks(std::size_t lane) const { return ticks[lane]; }
+	int getLength(std::size_t lane) const { return length[lane]; }
+	// Body length when the lane stopped playing; on game over, the length it
+	// had before the fatal tick.
+	int getFinalLength(std::size_t lane) const { return finalLength[lane]; }
+	int getHeadX(std::size_t lane) const { return headX[lane]; }
+	int getHeadY(std::size_t lane) const { return headY[lane]; }
+	// Off the board once the snake covers all of it.
+	int getFoodX(std::size_t lane) const { return foodX[lane]; }
+	int getFoodY(std::size_t lane) const { return foodY[lane]; }
+
+	// Identical to Game::stateHash() for a game in the same state.
+	std::uint64_t stateHash(std::size_t lane) const;
+
+	// Whether step() runs the AVX2 kernels; setVectorized(false) forces the
+	// scalar fallback, e.g. to compare the two.
+	static bool cpuHasAvx2();
+	bool isVectorized() const { return vectorized; }
+	void setVectorized(bool enable) { vectorized = enable && cpuHasAvx2(); }
+
+	// Raw view of the per lane arrays for the vector kernels. Every array has
+	// paddedLanes entries so kernels can always work on whole groups of 8.
+	struct Lanes {
+		std::size_t count;
+		std::int32_t* headX;
+		std::int32_t* headY;
+		std::int32_t* direction; // 0..3 for w, a, s, d
+		std::int32_t* input;     // -1 for no key
+		std::int32_t* newX;
+		std::int32_t* newY;
+		std::int32_t* newCell;
+		std::int32_t* active;    // -1 while the lane is playing, else 0
+		std::int32_t* ate;       // -1 if the head reached the food this tick
+		std::int32_t* length;
+		std::int32_t* pendingGrowth;
+		std::int32_t* points;
+		std::int32_t* speed;
+		std::int32_t* foodX;
+		std::int32_t* foodY;
+		std::int32_t* foodType;
+		std::int32_t stride;
+		std::int32_t cells;
+	};
+private:
+	std::size_t lanes;
+	std::size_t paddedLanes;
+	int columns, rows;
+	int stride;           // columns + 2, occupancy includes a wall border
+	int cells;            // columns * rows, the body capacity
+	std::size_t words;    // occupancy words per lane
+	bool vectorized;
+	long long tickLimit;
+
+	std::vector<std::int32_t> headX, headY, direction, input, newX, newY, newCell, active, ate;
+	std::vector<std::int32_t> length, pendingGrowth, points, speed, foodX, foodY, foodType;
+	std::vector<std::int32_t> ringHead;     // ring slot of the head
+	std::vector<std::int32_t> finalLength;
+	std::vector<std::int32_t> gameOver;
+	std::vector<long long> ticks;
+	std::vector<std::uint64_t> randomState, randomIncrement;
+	std::vector<float> red, green, blue;
+	std::vector<std::uint64_t> occupancy;   // words per lane
+	std::vector<std::uint64_t> border;      // occupancy of an empty board
+	std::vector<std::int32_t> body;         // cells per lane, padded cell indices
+	std::vector<FreeCells> freeCells;       // one per lane, the food spawns from it
+
+	Lanes view();
+	void moveBodies(std::size_t& crashes, std::size_t& limits);
+	void stopLimitedLanes();
+	void applyMeals();
+	void resetSnake(std::size_t lane);
+	void spawnFood(std::size_t lane);
+
+	std::int32_t cellIndex(int x, int y) const { return (y + 1) * stride + (x + 1); }
+	int cellX(std::int32_t cell) const { return cell % stride - 1; }
+	int cellY(std::int32_t cell) const { return cell / stride - 1; }
+	bool testCell(std::size_t lane, std::int32_t cell) const {
+		return (occupancy[lane * words + (cell >> 6)] >> (cell & 63)) & 1u;
+	}
+	void setCell(std::size_t lane, std::int32_t cell) {
+		occupancy[lane * words + (cell >> 6)] |= std::uint64_t(1) << (cell & 63);
+	}
+	void clearCell(std::size_t lane, std::int32_t cell) {
+		occupancy[lane * words + (cell >> 6)] &= ~(std::uint64_t(1) << (cell & 63));
+	}
+};
+
+// Vector kernels, BatchEngineAvx2.cpp, only built when SNAKE_HAVE_AVX2 is
+// defined. Each handles lanes [0, view.count) in groups of 8.
+void batchTurnAndAdvanceAvx2(const BatchEngine::Lanes& view);
+void batchEatAvx2(const BatchEngine::Lanes& view);
@@ -0,0 +1,77 @@
+// Built with AVX2 enabled (-mavx2 / /arch:AVX2), only called after
+// BatchEngine::cpuHasAvx2() said yes.
+#include "BatchEngine.h"
+#include "FoodRules.h"
+
+#include <immintrin.h>
+
+namespace {
+
+inline __m256i load(const std::int32_t* p) {
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline void store(std::int32_t* p, __m256i v) {
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+} // namespace
+
+// Apply this tick's key where it is not a reversal, then step the head.
+void batchTurnAndAdvanceAvx2(const BatchEngine::Lanes& v) {
+	const __m256i none = _mm256_set1_epi32(-1);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i two = _mm256_set1_epi32(2);
+	const __m256i three = _mm256_set1_epi32(3);
+	const __m256i stride = _mm256_set1_epi32(v.stride);
+
+	for (std::size_t i = 0; i < v.count; i += 8) {
+		const __m256i active = load(v.active + i);
+		const __m256i in = load(v.input + i);
+		__m256i dir = load(v.direction + i);
+
+		const __m256i pressed = _mm256_cmpgt_epi32(in, none);
+		const __m256i reverse = _mm256_cmpeq_epi32(in, _mm256_xor_si256(dir, two));
+		const __m256i turn = _mm256_and_si256(_mm256_andnot_si256(reverse, pressed), active);
+		dir = _mm256_blendv_epi8(dir, in, turn);
+
+		// w: y + 1, a: x - 1, s: y - 1, d: x + 1 (compares give -1 for true)
+		const __m256i dx = _mm256_sub_epi32(_mm256_cmpeq_epi32(dir, one), _mm256_cmpeq_epi32(dir, three));
+		const __m256i dy = _mm256_sub_epi32(_mm256_cmpeq_epi32(dir, two), _mm256_cmpeq_epi32(dir, zero));
+		const __m256i x = _mm256_add_epi32(load(v.headX + i), dx);
+		const __m256i y = _mm256_add_epi32(load(v.headY + i), dy);
+		const __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(y, one), stride), _mm256_add_epi32(x, one));
+
+		store(v.direction + i, dir);
+		store(v.newX + i, _mm256_blendv_epi8(load(v.newX + i), x, active));
+		store(v.newY + i, _mm256_blendv_epi8(load(v.newY + i), y, active));
+		store(v.newCell + i, _mm256_blendv_epi8(load(v.newCell + i), cell, active));
+	}
+}
+
+// Detect meals and apply the score, speed and growth parts of the food
+// effects with a lookup by food type.
+void batchEatAvx2(const BatchEngine::Lanes& v) {
+	static_assert(foodKindCount <= 8, "one food kind per 32 bit element");
+	const __m256i points = _mm256_setr_epi32(foodRules[0].points, foodRules[1].points, foodRules[2].points, foodRules[3].points, 0, 0, 0, 0);
+	const __m256i speed = _mm256_setr_epi32(foodRules[0].speedDelta, foodRules[1].speedDelta, foodRules[2].speedDelta,
+		foodRules[3].speedDelta, 0, 0, 0, 0);
+	const __m256i cells = _mm256_set1_epi32(v.cells);
+
+	for (std::size_t i = 0; i < v.count; i += 8) {
+		const __m256i onFood = _mm256_and_si256(_mm256_cmpeq_epi32(load(v.newX + i), load(v.foodX + i)),
+			_mm256_cmpeq_epi32(load(v.newY + i), load(v.foodY + i)));
+		const __m256i ate = _mm256_and_si256(onFood, load(v.active + i));
+		const __m256i type = load(v.foodType + i);
+
+		const __m256i length = load(v.length + i);
+		const __m256i pending = load(v.pendingGrowth + i);
+		const __m256i canGrow = _mm256_cmpgt_epi32(cells, _mm256_add_epi32(length, pending));
+
+		store(v.ate + i, ate);
+		store(v.points + i, _mm256_add_epi32(load(v.points + i), _mm256_and_si256(_mm256_permutevar8x32_epi32(points, type), ate)));
+		store(v.speed + i, _mm256_add_epi32(load(v.speed + i), _mm256_and_si256(_mm256_permutevar8x32_epi32(speed, type), ate)));
+		store(v.pendingGrowth + i, _mm256_sub_epi32(pending, _mm256_and_si256(ate, canGrow)));
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+//=================================================================================================
+// BOARD
+//=================================================================================================
+
+// Board geometry fixed at compile time: W x H cells of Cell pixels. Game,
+// Snake and OccupancyGrid take their size at run time (--columns, --rows);
+// this only names the default board's constants, for Game's default size
+// and the Renderer's cell size.
+template <int W, int H, int Cell>
+struct Board {
+	static_assert(W > 0 && H > 0 && Cell > 0, "a board has at least one cell of at least one pixel");
+
+	static constexpr int columns = W;
+	static constexpr int rows = H;
+	static constexpr int cellSize = Cell; // pixels
+};
+
+// The window's board: 27 x 20 cells of 30 pixels, 810 x 600.
+using DefaultBoard = Board<27, 20, 30>;
@@ -0,0 +1,88 @@
+#include "Bot.h"
+#include "Arena.h"
+#include "Game.h"
+
+#include <cstdlib>
+
+namespace {
+
+// The move towards (targetX, targetY) that does not run into a cell
+// isBlocked(x, y) reports, if there is one.
+template <typename IsBlocked>
+char greedyStep(const Snake& snake, int targetX, int targetY, IsBlocked isBlocked) {
+	static const char order[] = { 'w', 'a', 's', 'd' };
+	static const char opposite[] = { 's', 'd', 'w', 'a' };
+	const char current = snake.getDirection();
+	const SnakeSegment head = snake.getHead();
+
+	char best = current;
+	int bestScore = -1000000;
+	for (int i = 0; i < 4; ++i) {
+		const char direction = order[i];
+		if (current == opposite[i]) {
+			continue;
+		}
+
+		int x = head.x;
+		int y = head.y;
+		switch (direction) {
+		case 'w': y += 1; break;
+		case 'a': x -= 1; break;
+		case 's': y -= 1; break;
+		case 'd': x += 1; break;
+		}
+
+		int score = -(std::abs(targetX - x) + std::abs(targetY - y));
+		if (isBlocked(x, y)) {
+			score -= 100000;
+		}
+		if (score > bestScore) {
+			bestScore = score;
+			best = direction;
+		}
+	}
+	return best;
+}
+
+} // namespace
+
+char greedyDirection(const Game& game) {
+	const Snake& snake = game.getSnake();
+	const Food* food = game.getFood();
+	// With the board full any move that does not crash will do.
+	const int foodX = food ? food->getX() : snake.getHead().x;
+	const int foodY = food ? food->getY() : snake.getHead().y;
+	return greedyStep(snake, foodX, foodY, [&snake](int x, int y) { return snake.isOccupied(x, y); });
+}
+
+char greedyDirection(const Arena& arena, std::size_t snakeIndex) {
+	const Snake& snake = arena.getSnake(snakeIndex);
+	const SnakeSegment head = snake.getHead();
+	int targetX = head.x;
+	int targetY = head.y;
+	int nearest = -1;
+	for (std::size_t item = 0; item < arena.getFoodCount(); ++item) {
+		if (const Food* food = arena.getFood(item)) {
+			const int distance = std::abs(food->getX() - head.x) + std::abs(food->getY() - head.y);
+			if (nearest < 0 || distance < nearest) {
+				nearest = distance;
+				targetX = food->getX();
+				targetY = food->getY();
+			}
+		}
+	}
+	return greedyStep(snake, targetX, targetY, [&arena](int x, int y) { return arena.isBlocked(x, y); });
+}
+
+char cycleDirection(int x, int y, int columns, int rows) {
+	if (x == 0) {
+		return y > 0 ? 's' : 'd';
+	}
+	if (y % 2 == 0) {
+		return x < columns - 1 ? 'd' : 'w';
+	}
+	if (x > 1) {
+		return 'a';
+	}
+	return y < rows - 1 ? 'w' : 'a';
+}
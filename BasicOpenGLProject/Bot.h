@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+class Arena;
+class Game;
+
+//=================================================================================================
+// BOT
+//=================================================================================================
+
+// Greedy bot: head towards the food, never straight into a wall or the body
+// when there is any other choice. Returns one of 'w', 'a', 's', 'd'.
+char greedyDirection(const Game& game);
+// The same for snake snakeIndex of an arena, heading for the nearest food
+// and avoiding every snake's body.
+char greedyDirection(const Arena& arena, std::size_t snakeIndex);
+
+// Direction along a Hamiltonian cycle of a board with an even number of
+// rows: right and left along the rows from column 1, then back down column
+// 0. With a multiple of 4 rows the start cell heading right is on it, and a
+// snake of any length up to the whole board can follow it forever without
+// crashing.
+char cycleDirection(int x, int y, int columns, int rows);
@@ -0,0 +1,62 @@
+#include "FixedTimestep.h"
+
+#include <cmath>
+
+FixedTimestep::FixedTimestep() {
+	reset();
+}
+
+void FixedTimestep::reset() {
+	accumulator = Clock::duration::zero();
+	alpha = 0.0f;
+	started = false;
+	tickedBefore = false;
+	resetJitter();
+}
+
+void FixedTimestep::resetJitter() {
+	jitterTotalMs = 0.0;
+	jitterMaxMs = 0.0;
+	jitterTicks = 0;
+}
+
+int FixedTimestep::advance(int tickMs) {
+	return advance(tickMs, Clock::now());
+}
+
+int FixedTimestep::advance(int tickMs, Clock::time_point now) {
+	const Clock::duration tick = std::chrono::milliseconds(tickMs > 0 ? tickMs : 1);
+	if (!started) {
+		started = true;
+		last = now;
+	}
+	accumulator += now - last;
+	last = now;
+
+	int ticks = 0;
+	while (accumulator >= tick && ticks < maxCatchUpTicks) {
+		accumulator -= tick;
+		++ticks;
+	}
+	if (ticks == maxCatchUpTicks && accumulator >= tick) {
+		accumulator = accumulator % tick;
+	}
+	alpha = static_cast<float>(std::chrono::duration<double>(accumulator) / std::chrono::duration<double>(tick));
+
+	if (ticks > 0) {
+		// Jitter is only meaningful between ticks run on different calls,
+		// catch-up ticks run back to back by design.
+		if (tickedBefore) {
+			const double intervalMs = std::chrono::duration<double, std::milli>(now - lastTick).count();
+			const double jitterMs = std::fabs(intervalMs - ticks * static_cast<double>(tickMs));
+			jitterTotalMs += jitterMs;
+			if (jitterMs > jitterMaxMs) {
+				jitterMaxMs = jitterMs;
+			}
+			++jitterTicks;
+		}
+		lastTick = now;
+		tickedBefore = true;
+	}
+	return ticks;
+}
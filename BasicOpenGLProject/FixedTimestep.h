@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+
+//=================================================================================================
+// FIXED TIMESTEP
+//=================================================================================================
+
+// Accumulator driven game clock. Each call to advance() adds the real time
+// since the previous call, measured on a monotonic clock, and returns how many
+// whole ticks are due; the remainder carries over, so the tick rate does not
+// drift with how long frames take to render. getAlpha() is how far the clock
+// is into the next tick, for interpolating what is drawn between two ticks.
+//
+// Also measures jitter: how far the real interval between two consecutive
+// ticks strays from the nominal tick interval.
+class FixedTimestep {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// After a long stall (debugger, window drag) run at most this many ticks
+	// at once and drop the rest instead of fast-forwarding the game.
+	static const int maxCatchUpTicks = 5;
+
+	FixedTimestep();
+
+	void reset();
+	int advance(int tickMs);
+	int advance(int tickMs, Clock::time_point now);
+	float getAlpha() const { return alpha; }
+
+	double getJitterMeanMs() const { return jitterTicks > 0 ? jitterTotalMs / jitterTicks : 0.0; }
+	double getJitterMaxMs() const { return jitterMaxMs; }
+	long long getJitterTicks() const { return jitterTicks; }
+	void resetJitter();
+private:
+	Clock::time_point last;
+	Clock::time_point lastTick;
+	Clock::duration accumulator;
+	float alpha;
+	bool started;
+	bool tickedBefore;
+
+	double jitterTotalMs;
+	double jitterMaxMs;
+	long long jitterTicks;
+};
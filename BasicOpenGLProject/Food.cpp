@@ -0,0 +1,16 @@
+#include "Food.h"
+#include "Random.h"
+#include "Snake.h"
+
+bool Food::placeRandom(const Snake& snake, Random& random) {
+	int cellX, cellY;
+	if (!snake.pickFreeCell(random, cellX, cellY)) {
+		return false;
+	}
+	placeAt(cellX, cellY);
+	return true;
+}
+
+void Food::foodEffect(Snake& snake, Random& random) const {
+	applyFoodRule(getRule(), snake, random);
+}
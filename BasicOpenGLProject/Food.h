@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FoodRules.h"
+
+class Random;
+class Snake;
+
+//=================================================================================================
+// FOOD
+//=================================================================================================
+
+class GameObject {
+public:
+	virtual void foodEffect(Snake& snake, Random& random) const = 0;
+	virtual ~GameObject() {}
+};
+
+// Food knows its cell and kind but not how to draw itself, so the simulation
+// can run without a GL context. See Renderer.
+//
+// What a kind looks like and does is in the foodRules table (FoodRules.h);
+// Apple, Orange, Grape and Banana only pick the kind. Nothing here is
+// virtual past GameObject, so code holding a Food calls straight into the
+// table instead of through the vtable.
+class Food : public GameObject {
+protected:
+	int x, y;
+	FoodKind kind;
+
+	explicit Food(FoodKind kind) : x(0), y(0), kind(kind) {}
+public:
+	~Food() {}
+	// Moves to a uniformly chosen cell the snake is not on. False, leaving the
+	// food where it was, if the snake covers the whole board.
+	bool placeRandom(const Snake& snake, Random& random);
+	void placeAt(int cellX, int cellY) {
+		x = cellX;
+		y = cellY;
+	}
+
+	void foodEffect(Snake& snake, Random& random) const final;
+	FoodKind getKind() const { return kind; }
+	const FoodRule& getRule() const { return foodRule(kind); }
+	float getRed() const { return getRule().red; }
+	float getGreen() const { return getRule().green; }
+	float getBlue() const { return getRule().blue; }
+	int getX() const { return x; }
+	int getY() const { return y; }
+};
+
+class Apple : public Food {
+public:
+	Apple() : Food(FoodKind::Apple) {}
+};
+
+class Orange : public Food {
+public:
+	Orange() : Food(FoodKind::Orange) {}
+};
+
+class Grape : public Food {
+public:
+	Grape() : Food(FoodKind::Grape) {}
+};
+
+class Banana : public Food {
+public:
+	Banana() : Food(FoodKind::Banana) {}
+};
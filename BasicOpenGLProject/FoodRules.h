@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+//=================================================================================================
+// FOOD RULES
+//=================================================================================================
+
+// What each kind of food looks like and does to the snake that eats it, as
+// one constexpr table instead of a virtual function per kind. Game, Arena
+// and the BatchEngine all read it, so a rule changed here changes everywhere.
+
+// In the order Game::spawnFood() draws them; replays and state hashes store
+// the number.
+enum class FoodKind { Apple, Orange, Grape, Banana };
+
+struct FoodRule {
+	float red, green, blue;
+	int points;
+	int speedDelta; // added to the tick interval, so negative is faster
+	int growth;     // segments added
+	bool recolor;   // paints the snake a random color
+};
+
+constexpr std::size_t foodKindCount = 4;
+
+constexpr FoodRule foodRules[foodKindCount] = {
+	{ 1.0f, 0.0f, 0.0f, 1, -5, 1, false }, // Apple
+	{ 1.0f, 0.5f, 0.0f, 1, 5, 1, false },  // Orange
+	{ 0.5f, 0.0f, 1.0f, 5, 0, 1, false },  // Grape
+	{ 1.0f, 1.0f, 0.0f, 1, 0, 1, true },   // Banana
+};
+
+constexpr const FoodRule& foodRule(FoodKind kind) {
+	return foodRules[static_cast<std::size_t>(kind)];
+}
+
+// Applies a rule to anything with the Snake interface.
+template <class SnakeT, class RandomT>
+void applyFoodRule(const FoodRule& rule, SnakeT& snake, RandomT& random) {
+	snake.addPoints(rule.points);
+	if (rule.speedDelta != 0) {
+		snake.changeSpeed(rule.speedDelta);
+	}
+	if (rule.recolor) {
+		snake.changeColorToRandom(random);
+	}
+	for (int i = 0; i < rule.growth; ++i) {
+		snake.grow();
+	}
+}
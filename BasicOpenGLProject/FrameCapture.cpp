@@ -0,0 +1,257 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Full range BT.601 in 8 bit fixed point, as JPEG has it. The offsets keep
+// the sums positive; chroma can round up to 256.
+unsigned char luma(int r, int g, int b) {
+	return static_cast<unsigned char>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+unsigned char chromaBlue(int r, int g, int b) {
+	return static_cast<unsigned char>(std::min((-43 * r - 85 * g + 128 * b + 32896) >> 8, 255));
+}
+
+unsigned char chromaRed(int r, int g, int b) {
+	return static_cast<unsigned char>(std::min((128 * r - 107 * g - 21 * b + 32896) >> 8, 255));
+}
+
+} // namespace
+
+FrameCapture::FrameCapture()
+	: file(nullptr), ownsFile(false), format(Format::Ppm), width(0), height(0), async(false), pixelBuffers(), framesRead(0), framesWritten(0),
+	bytesWritten(0), seconds(0.0), failed(false) {}
+
+FrameCapture::~FrameCapture() {
+	// Without a context to drain the pixel buffers from, frames still in
+	// flight are lost; close() first.
+	if (file && ownsFile) {
+		std::fclose(file);
+	}
+}
+
+FrameCapture::Format FrameCapture::formatFor(const std::string& path) {
+	const std::string extension = ".y4m";
+	const bool y4m = path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+	return y4m ? Format::Y4m : Format::Ppm;
+}
+
+bool FrameCapture::parseFormat(const std::string& name, Format& format) {
+	if (name == "ppm") {
+		format = Format::Ppm;
+	}
+	else if (name == "y4m") {
+		format = Format::Y4m;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+bool FrameCapture::open(GLProcLoader loader, const std::string& path, Format newFormat, int newWidth, int newHeight, int fps, bool wantAsync) {
+	close();
+	if (newWidth < 1 || newHeight < 1 || fps < 1) {
+		std::cerr << "capture: nothing to capture at " << newWidth << " x " << newHeight << " and " << fps << " fps\n";
+		return false;
+	}
+	if (path == "-") {
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		file = stdout;
+		ownsFile = false;
+	}
+	else {
+		file = std::fopen(path.c_str(), "wb");
+		ownsFile = true;
+		if (!file) {
+			std::cerr << "capture: cannot write " << path << "\n";
+			return false;
+		}
+	}
+
+	format = newFormat;
+	width = newWidth;
+	height = newHeight;
+	framesRead = 0;
+	framesWritten = 0;
+	bytesWritten = 0;
+	seconds = 0.0;
+	failed = false;
+	encoded.reserve(format == Format::Ppm ? frameBytes() : frameBytes() / 2);
+
+	if (format == Format::Y4m) {
+		char header[96];
+		const int length = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+		failed = std::fwrite(header, 1, length, file) != static_cast<std::size_t>(length);
+		bytesWritten += length;
+	}
+
+	gl.load(loader);
+	async = wantAsync && gl.hasPixelBuffers();
+	if (async) {
+		gl.GenBuffers(pixelBufferCount, pixelBuffers);
+		for (GLuint buffer : pixelBuffers) {
+			gl.BindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+			gl.BufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLExtensions::GLsizeiptr>(frameBytes()), nullptr, GL_STREAM_READ);
+		}
+		gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	else {
+		pixels.resize(frameBytes());
+	}
+	return true;
+}
+
+bool FrameCapture::close() {
+	if (!file) {
+		return true;
+	}
+	const Clock::time_point start = Clock::now();
+	if (isAsync()) {
+		for (long long frame = std::max(framesRead - pixelBufferCount, 0LL); frame < framesRead; ++frame) {
+			writeFrom(pixelBuffers[frame % pixelBufferCount]);
+		}
+		gl.DeleteBuffers(pixelBufferCount, pixelBuffers);
+		std::fill(pixelBuffers, pixelBuffers + pixelBufferCount, 0);
+	}
+	failed |= std::fflush(file) != 0;
+	if (ownsFile) {
+		failed |= std::fclose(file) != 0;
+	}
+	file = nullptr;
+	seconds += secondsSince(start);
+	return !failed;
+}
+
+void FrameCapture::capture() {
+	if (!file) {
+		return;
+	}
+	const Clock::time_point start = Clock::now();
+	if (isAsync()) {
+		// The oldest buffer goes out before it is read into again.
+		const GLuint buffer = pixelBuffers[framesRead % pixelBufferCount];
+		if (framesRead >= pixelBufferCount) {
+			writeFrom(buffer);
+		}
+		gl.BindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+		readInto(buffer);
+		gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	else {
+		readInto(0);
+		write(pixels.data());
+	}
+	++framesRead;
+	seconds += secondsSince(start);
+}
+
+// Into the bound pixel buffer, or pixels without one.
+void FrameCapture::readInto(GLuint buffer) {
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, buffer ? nullptr : pixels.data());
+}
+
+void FrameCapture::writeFrom(GLuint buffer) {
+	gl.BindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	if (const void* mapped = gl.MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY)) {
+		write(static_cast<const unsigned char*>(mapped));
+		gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else {
+		failed = true;
+	}
+	gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::write(const unsigned char* rgba) {
+	encoded.clear();
+	if (format == Format::Ppm) {
+		encodePpm(rgba);
+	}
+	else {
+		encodeY4m(rgba);
+	}
+	failed |= std::fwrite(encoded.data(), 1, encoded.size(), file) != encoded.size();
+	bytesWritten += static_cast<long long>(encoded.size());
+	++framesWritten;
+}
+
+// GL rows go bottom up, both formats top down.
+void FrameCapture::encodePpm(const unsigned char* rgba) {
+	char header[32];
+	const int length = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+	encoded.insert(encoded.end(), header, header + length);
+	const std::size_t start = encoded.size();
+	encoded.resize(start + static_cast<std::size_t>(width) * height * 3);
+	unsigned char* out = encoded.data() + start;
+	for (int y = height - 1; y >= 0; --y) {
+		const unsigned char* pixel = rgba + static_cast<std::size_t>(y) * width * 4;
+		for (int x = 0; x < width; ++x, pixel += 4, out += 3) {
+			out[0] = pixel[0];
+			out[1] = pixel[1];
+			out[2] = pixel[2];
+		}
+	}
+}
+
+// One pass over pairs of rows, top row first. Chroma is the average of each
+// 2 x 2 block, or of what is left of one at an odd edge.
+void FrameCapture::encodeY4m(const unsigned char* rgba) {
+	static const char frameHeader[] = "FRAME\n";
+	encoded.insert(encoded.end(), frameHeader, frameHeader + sizeof(frameHeader) - 1);
+	const std::size_t start = encoded.size();
+	const int chromaWidth = (width + 1) / 2;
+	const int chromaHeight = (height + 1) / 2;
+	const std::size_t lumaSize = static_cast<std::size_t>(width) * height;
+	const std::size_t chromaSize = static_cast<std::size_t>(chromaWidth) * chromaHeight;
+	encoded.resize(start + lumaSize + 2 * chromaSize);
+	unsigned char* lumaRow = encoded.data() + start;
+	unsigned char* blue = lumaRow + lumaSize;
+	unsigned char* red = blue + chromaSize;
+
+	const std::size_t stride = static_cast<std::size_t>(width) * 4;
+	for (int row = 0; row < height; row += 2) {
+		const bool pair = row + 1 < height;
+		const unsigned char* top = rgba + (height - 1 - row) * stride;
+		const unsigned char* bottom = pair ? top - stride : top;
+		unsigned char* lumaBelow = pair ? lumaRow + width : lumaRow;
+		for (int x = 0; x < width; x += 2) {
+			const int pixels = x + 1 < width ? 2 : 1;
+			int r = 0, g = 0, b = 0;
+			for (int i = 0; i < pixels; ++i) {
+				const unsigned char* above = top + (x + i) * 4;
+				const unsigned char* below = bottom + (x + i) * 4;
+				lumaRow[x + i] = luma(above[0], above[1], above[2]);
+				lumaBelow[x + i] = luma(below[0], below[1], below[2]);
+				r += above[0] + below[0];
+				g += above[1] + below[1];
+				b += above[2] + below[2];
+			}
+			// An unpaired row or column was counted twice, as its own neighbor.
+			const int count = 2 * pixels;
+			r = (r + count / 2) / count;
+			g = (g + count / 2) / count;
+			b = (b + count / 2) / count;
+			*blue++ = chromaBlue(r, g, b);
+			*red++ = chromaRed(r, g, b);
+		}
+		lumaRow += pair ? 2 * width : width;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "GLExtensions.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// FRAME CAPTURE
+//=================================================================================================
+
+// Streams rendered frames to a file or pipe as raw video an encoder can read,
+// e.g. snake_offscreen --capture - | ffmpeg -i - game.mp4.
+//
+// capture() only starts reading the frame back, into one of a few pixel
+// buffer objects, and writes out the frame read pixelBufferCount calls
+// earlier, which the GL has long finished with by then, so the render loop
+// never waits on a readback. Without pixel buffer objects every frame is
+// read back on the spot instead.
+//
+// Ppm writes each frame as a binary PPM image, one after the other; Y4m
+// writes a YUV4MPEG2 stream, 4:2:0 full range BT.601, at the given frame
+// rate.
+class FrameCapture {
+public:
+	enum class Format { Ppm, Y4m };
+
+	static const int pixelBufferCount = 3;
+
+	FrameCapture();
+	~FrameCapture();
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// Y4m for a path ending in ".y4m", Ppm otherwise.
+	static Format formatFor(const std::string& path);
+	// Parses "ppm" or "y4m".
+	static bool parseFormat(const std::string& name, Format& format);
+
+	// Opens path, "-" for standard output, for width x height frames; a
+	// context must be current. async false reads every frame back on the
+	// spot, for comparison. Prints the reason and returns false on failure.
+	bool open(GLProcLoader loader, const std::string& path, Format format, int width, int height, int fps, bool async = true);
+	// Writes the frames still in flight and closes the output, call while
+	// the context is still current. False if any write failed.
+	bool close();
+
+	// Captures the bottom left width x height pixels of the read
+	// framebuffer, after drawing and before swapping buffers.
+	void capture();
+
+	bool isOpen() const { return file != nullptr; }
+	// Whether the last open() got pixel buffers, still true after close().
+	bool isAsync() const { return async; }
+
+	long long getFrames() const { return framesWritten; }
+	long long getBytes() const { return bytesWritten; }
+	// Time spent in capture() and close(), readback, conversion and writing.
+	double getSeconds() const { return seconds; }
+private:
+	GLExtensions gl;
+	std::FILE* file;
+	bool ownsFile;
+	Format format;
+	int width, height;
+	bool async;
+	GLuint pixelBuffers[pixelBufferCount];
+	long long framesRead; // pixelBuffers[framesRead % pixelBufferCount] is the next to read into
+	long long framesWritten;
+	long long bytesWritten;
+	double seconds;
+	bool failed;
+	std::vector<unsigned char> pixels; // RGBA, bottom row first, without pixel buffers
+	std::vector<unsigned char> encoded; // one frame as written
+
+	std::size_t frameBytes() const { return static_cast<std::size_t>(width) * height * 4; }
+	void readInto(GLuint buffer);
+	// Writes the frame read into buffer.
+	void writeFrom(GLuint buffer);
+	void write(const unsigned char* rgba);
+	void encodePpm(const unsigned char* rgba);
+	void encodeY4m(const unsigned char* rgba);
+};
@@ -0,0 +1,37 @@
+#include "FreeCells.h"
+#include "StateHash.h"
+
+FreeCells::FreeCells(int columns, int rows)
+	: FreeCells(columns, rows, fitsIndex(columns, rows)) {}
+
+FreeCells::FreeCells(int columns, int rows, bool indexed)
+	: columns(columns), rows(rows), stride(columns + 2), indexed(indexed), freeCount(0) {
+	if (indexed) {
+		cells.resize(static_cast<std::size_t>(columns) * rows);
+		slots.resize(static_cast<std::size_t>(stride) * (rows + 2));
+	}
+	reset();
+}
+
+void FreeCells::reset() {
+	freeCount = static_cast<std::size_t>(columns) * rows;
+	if (!indexed) {
+		return;
+	}
+	std::uint32_t slot = 0;
+	for (int y = 0; y < rows; ++y) {
+		for (int x = 0; x < columns; ++x) {
+			const std::uint32_t cell = cellIndex(x, y);
+			cells[slot] = cell;
+			slots[cell] = slot;
+			++slot;
+		}
+	}
+}
+
+void FreeCells::hashOrder(std::uint64_t& hash) const {
+	hashValue(hash, indexed);
+	if (indexed) {
+		hashBytes(hash, cells.data(), freeCount * sizeof(std::uint32_t));
+	}
+}
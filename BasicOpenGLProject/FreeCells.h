@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Random.h"
+
+//=================================================================================================
+// FREE CELLS
+//=================================================================================================
+
+// The board cells no segment is on, kept so food can spawn on a uniformly
+// chosen free cell in constant time however full the board is.
+//
+// Boards up to maxIndexedCells keep every cell in one array with the free
+// cells first, and each cell's slot in that array: taking or releasing a
+// cell swaps it across the boundary, and a spawn is one random slot below
+// it. Cells are numbered like OccupancyGrid::cellIndex(), border included,
+// so callers that already have that index pass it straight in.
+//
+// Larger boards only count the free cells; a spawn tries random cells until
+// one is free and, if the board is so full that keeps missing, picks the
+// n-th free cell by scanning, which is just as uniform.
+class FreeCells {
+private:
+	int columns, rows;
+	int stride; // columns + 2, as in OccupancyGrid
+	bool indexed;
+	std::size_t freeCount;
+	std::vector<std::uint32_t> cells; // free cells in [0, freeCount)
+	std::vector<std::uint32_t> slots; // where each cell is in cells, by cell index
+
+	static const int maxTries = 64;
+
+	void swapSlots(std::uint32_t slot, std::uint32_t other) {
+		const std::uint32_t cell = cells[slot];
+		cells[slot] = cells[other];
+		cells[other] = cell;
+		slots[cells[slot]] = slot;
+		slots[cell] = other;
+	}
+public:
+	static const std::size_t maxIndexedCells = std::size_t(1) << 20;
+
+	static bool fitsIndex(int columns, int rows) {
+		return static_cast<std::size_t>(columns) * rows <= maxIndexedCells;
+	}
+
+	// Indexed if the board fits, see fitsIndex().
+	FreeCells(int columns, int rows);
+	FreeCells(int columns, int rows, bool indexed);
+
+	bool isIndexed() const { return indexed; }
+	std::size_t size() const { return freeCount; }
+
+	// Every cell free again.
+	void reset();
+
+	std::uint32_t cellIndex(int x, int y) const {
+		return static_cast<std::uint32_t>(y + 1) * stride + static_cast<std::uint32_t>(x + 1);
+	}
+
+	// Only cells on the board, and only a free cell may be taken and a taken
+	// one released.
+	void take(std::uint32_t cell) {
+		if (indexed) {
+			swapSlots(slots[cell], static_cast<std::uint32_t>(freeCount - 1));
+		}
+		--freeCount;
+	}
+	void release(std::uint32_t cell) {
+		if (indexed) {
+			swapSlots(slots[cell], static_cast<std::uint32_t>(freeCount));
+		}
+		++freeCount;
+	}
+	void take(int x, int y) { take(cellIndex(x, y)); }
+	void release(int x, int y) { release(cellIndex(x, y)); }
+
+	// The free cell in slot, below size(); indexed boards only. The order
+	// decides which cell pick() draws, Snapshot saves and restores it.
+	std::uint32_t getFree(std::size_t slot) const { return cells[slot]; }
+	// Adds the order to a state hash, nothing but the flag if not indexed.
+	void hashOrder(std::uint64_t& hash) const;
+	// Moves a free cell on the board into slot, for restoring an order slot
+	// by slot from 0. False if the cell is not free or already placed below
+	// slot.
+	bool placeFree(std::size_t slot, std::uint32_t cell) {
+		if (cell >= slots.size() || slots[cell] < slot || slots[cell] >= freeCount) {
+			return false;
+		}
+		swapSlots(static_cast<std::uint32_t>(slot), slots[cell]);
+		return true;
+	}
+
+	// Picks a free cell uniformly, false if there is none. isTaken(x, y) must
+	// agree with take() and release(); only boards that are not indexed call
+	// it.
+	template <class IsTaken>
+	bool pick(Random& random, IsTaken isTaken, int& x, int& y) const {
+		if (freeCount == 0) {
+			return false;
+		}
+		if (indexed) {
+			const std::uint32_t cell = cells[random.nextBelow(static_cast<std::uint32_t>(freeCount))];
+			x = static_cast<int>(cell % stride) - 1;
+			y = static_cast<int>(cell / stride) - 1;
+			return true;
+		}
+		for (int i = 0; i < maxTries; ++i) {
+			x = static_cast<int>(random.nextBelow(static_cast<std::uint32_t>(columns)));
+			y = static_cast<int>(random.nextBelow(static_cast<std::uint32_t>(rows)));
+			if (!isTaken(x, y)) {
+				return true;
+			}
+		}
+		std::size_t skip = random.nextBelow(static_cast<std::uint32_t>(freeCount));
+		for (y = 0; y < rows; ++y) {
+			for (x = 0; x < columns; ++x) {
+				if (!isTaken(x, y) && skip-- == 0) {
+					return true;
+				}
+			}
+		}
+		return false; // isTaken disagrees with the count
+	}
+};
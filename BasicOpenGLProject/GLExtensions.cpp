@@ -0,0 +1,31 @@
+#include "GLExtensions.h"
+
+namespace {
+
+template <typename T>
+void loadProc(GLProcLoader loader, T& proc, const char* name) {
+	proc = reinterpret_cast<T>(loader(name));
+}
+
+} // namespace
+
+void GLExtensions::load(GLProcLoader loader) {
+	loadProc(loader, GenBuffers, "glGenBuffers");
+	loadProc(loader, DeleteBuffers, "glDeleteBuffers");
+	loadProc(loader, BindBuffer, "glBindBuffer");
+	loadProc(loader, BufferData, "glBufferData");
+	loadProc(loader, BufferSubData, "glBufferSubData");
+	loadProc(loader, MapBuffer, "glMapBuffer");
+	loadProc(loader, UnmapBuffer, "glUnmapBuffer");
+
+	loadProc(loader, GenFramebuffers, "glGenFramebuffers");
+	loadProc(loader, DeleteFramebuffers, "glDeleteFramebuffers");
+	loadProc(loader, BindFramebuffer, "glBindFramebuffer");
+	loadProc(loader, CheckFramebufferStatus, "glCheckFramebufferStatus");
+	loadProc(loader, FramebufferRenderbuffer, "glFramebufferRenderbuffer");
+	loadProc(loader, GenRenderbuffers, "glGenRenderbuffers");
+	loadProc(loader, DeleteRenderbuffers, "glDeleteRenderbuffers");
+	loadProc(loader, BindRenderbuffer, "glBindRenderbuffer");
+	loadProc(loader, RenderbufferStorage, "glRenderbufferStorage");
+	loadProc(loader, BlitFramebuffer, "glBlitFramebuffer");
+}
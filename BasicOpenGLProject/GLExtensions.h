@@ -0,0 +1,93 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+
+#include <cstddef>
+
+//=================================================================================================
+// GL EXTENSIONS
+//=================================================================================================
+
+// The system GL headers only promise OpenGL 1.1 (that is all Windows ships),
+// so anything newer is looked up at runtime through the loader of whichever
+// library created the context: glutGetProcAddress or eglGetProcAddress.
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_READ_ONLY 0x88B8
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_RENDERBUFFER 0x8D41
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+
+#ifndef GL_READ_FRAMEBUFFER
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#endif
+
+typedef void (*GLProc)();
+typedef GLProc (*GLProcLoader)(const char* name);
+
+struct GLExtensions {
+	typedef std::ptrdiff_t GLsizeiptr;
+	typedef std::ptrdiff_t GLintptr;
+
+	// Buffer objects (OpenGL 1.5)
+	void (APIENTRY* GenBuffers)(GLsizei n, GLuint* buffers) = nullptr;
+	void (APIENTRY* DeleteBuffers)(GLsizei n, const GLuint* buffers) = nullptr;
+	void (APIENTRY* BindBuffer)(GLenum target, GLuint buffer) = nullptr;
+	void (APIENTRY* BufferData)(GLenum target, GLsizeiptr size, const void* data, GLenum usage) = nullptr;
+	void (APIENTRY* BufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) = nullptr;
+	void* (APIENTRY* MapBuffer)(GLenum target, GLenum access) = nullptr;
+	GLboolean (APIENTRY* UnmapBuffer)(GLenum target) = nullptr;
+
+	// Framebuffer objects (OpenGL 3.0 / ARB_framebuffer_object)
+	void (APIENTRY* GenFramebuffers)(GLsizei n, GLuint* framebuffers) = nullptr;
+	void (APIENTRY* DeleteFramebuffers)(GLsizei n, const GLuint* framebuffers) = nullptr;
+	void (APIENTRY* BindFramebuffer)(GLenum target, GLuint framebuffer) = nullptr;
+	GLenum (APIENTRY* CheckFramebufferStatus)(GLenum target) = nullptr;
+	void (APIENTRY* FramebufferRenderbuffer)(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer) = nullptr;
+	void (APIENTRY* GenRenderbuffers)(GLsizei n, GLuint* renderbuffers) = nullptr;
+	void (APIENTRY* DeleteRenderbuffers)(GLsizei n, const GLuint* renderbuffers) = nullptr;
+	void (APIENTRY* BindRenderbuffer)(GLenum target, GLuint renderbuffer) = nullptr;
+	void (APIENTRY* RenderbufferStorage)(GLenum target, GLenum format, GLsizei width, GLsizei height) = nullptr;
+	void (APIENTRY* BlitFramebuffer)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+		GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) = nullptr;
+
+	// Fills in every entry point the loader can find. A context is current.
+	void load(GLProcLoader loader);
+
+	bool hasBuffers() const { return GenBuffers && DeleteBuffers && BindBuffer && BufferData && BufferSubData; }
+	// Pixel buffer objects, for reading pixels back without waiting (OpenGL 2.1).
+	bool hasPixelBuffers() const { return hasBuffers() && MapBuffer && UnmapBuffer; }
+	bool hasFramebuffers() const {
+		return GenFramebuffers && DeleteFramebuffers && BindFramebuffer && CheckFramebufferStatus && FramebufferRenderbuffer
+			&& GenRenderbuffers && DeleteRenderbuffers && BindRenderbuffer && RenderbufferStorage;
+	}
+	// Copying between framebuffers, separate read and draw bindings.
+	bool hasBlit() const { return hasFramebuffers() && BlitFramebuffer; }
+};
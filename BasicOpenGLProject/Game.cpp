@@ -0,0 +1,120 @@
+#include "Game.h"
+#include "StateHash.h"
+
+static bool isCollision(int x1, int y1, int x2, int y2) {
+	return x1 == x2 && y1 == y2;
+}
+
+Game::Game(int columns, int rows, std::uint64_t seed, bool indexFreeCells)
+	: columns(columns), rows(rows), seed(seed), random(seed), snake(columns / 2, rows / 2, columns, rows, indexFreeCells), food(nullptr),
+	gameOver(false), ticks(0) {
+	spawnFood();
+}
+
+void Game::spawnFood() {
+	switch (random.nextBelow(4)) {
+	case 0:
+		food = &apple;
+		break;
+	case 1:
+		food = &orange;
+		break;
+	case 2:
+		food = &grape;
+		break;
+	case 3:
+		food = &banana;
+		break;
+	}
+	if (!food->placeRandom(snake, random)) {
+		food = nullptr; // the snake fills the board
+	}
+}
+
+// Walls and the body share the snake's occupancy grid, so one bit test
+// covers both.
+void Game::checkCollision() {
+	if (snake.hasCrashed()) {
+		handleGameOver();
+	}
+}
+
+void Game::handleGameOver() {
+	gameOver = true;
+}
+
+void Game::restartGame() {
+	newGame(seed);
+}
+
+void Game::newGame(std::uint64_t newSeed) {
+	seed = newSeed;
+	random.reseed(newSeed);
+	snake.reset();
+	snake.resetPoints();
+	gameOver = false;
+	ticks = 0;
+	spawnFood();
+}
+
+int Game::getTickInterval() const {
+	const int speed = snake.getSpeed();
+	if (speed < minTickInterval) {
+		return minTickInterval;
+	}
+	if (speed > maxTickInterval) {
+		return maxTickInterval;
+	}
+	return speed;
+}
+
+void Game::update() {
+	if (gameOver) {
+		return;
+	}
+
+	++ticks;
+	snake.move();
+	checkCollision();
+	if (gameOver) {
+		return;
+	}
+
+	if (food && isCollision(snake.getHead().x, snake.getHead().y, food->getX(), food->getY())) {
+		food->foodEffect(snake, random);
+		spawnFood();
+	}
+}
+
+std::uint64_t Game::stateHash() const {
+	std::uint64_t hash = stateHashSeed;
+	hashValue(hash, ticks);
+	hashValue(hash, gameOver);
+	hashValue(hash, random.getState());
+	hashValue(hash, snake.getPoints());
+	hashValue(hash, snake.getSpeed());
+	hashValue(hash, snake.getDirection());
+	hashValue(hash, snake.getRed());
+	hashValue(hash, snake.getGreen());
+	hashValue(hash, snake.getBlue());
+	for (const auto& segment : snake.getBody()) {
+		hashValue(hash, segment.x);
+		hashValue(hash, segment.y);
+	}
+	hashValue(hash, snake.getPendingGrowth());
+	const InputRing& inputs = snake.getInputs();
+	hashValue(hash, inputs.size());
+	for (int i = 0; i < inputs.size(); ++i) {
+		hashValue(hash, inputs[i].direction);
+	}
+	if (!food) {
+		hashValue(hash, -1);
+	}
+	else {
+		hashValue(hash, static_cast<int>(food->getKind()));
+		hashValue(hash, food->getX());
+		hashValue(hash, food->getY());
+	}
+	snake.getFreeCells().hashOrder(hash);
+	return hash;
+}
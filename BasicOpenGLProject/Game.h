@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Board.h"
+#include "Food.h"
+#include "Random.h"
+#include "Snake.h"
+
+#include <cstdint>
+
+//=================================================================================================
+// GAME
+//=================================================================================================
+
+// One complete game of snake: the board, the snake, the food and the score.
+// Game has no GL or GLUT dependency, the window and the headless runner both
+// drive it by calling update() once per tick.
+//
+// All randomness comes from the game's own seeded Random, so the same seed
+// and the same setDirection() calls on the same ticks replay a game exactly.
+class Game {
+private:
+	int columns, rows;
+	std::uint64_t seed;
+	Random random;
+	Snake snake;
+
+	// One object of each food type is created up front, food points at
+	// whichever is on the board so eating never touches the heap.
+	Apple apple;
+	Orange orange;
+	Grape grape;
+	Banana banana;
+	Food* food;
+	bool gameOver;
+	long long ticks;
+
+	void spawnFood();
+
+	friend class Snapshot;
+public:
+	static const int defaultColumns = DefaultBoard::columns; // 810 pixels
+	static const int defaultRows = DefaultBoard::rows;       // 600 pixels
+	// Largest board side the front ends accept. Replays store sizes in 16 bits.
+	static const int maxBoardSize = 10000;
+
+	// Food changes the snake's speed without bounds, the tick interval in
+	// milliseconds is kept within these.
+	static const int minTickInterval = 30;
+	static const int maxTickInterval = 250;
+
+	// A game only drawn, restored from Display snapshots, has no use for the
+	// free cell index, see FreeCells.
+	Game(int columns = defaultColumns, int rows = defaultRows, std::uint64_t seed = 1, bool indexFreeCells = true);
+	~Game() {}
+	Game(const Game&) = delete;
+	Game& operator=(const Game&) = delete;
+
+	void update();
+	void checkCollision();
+	// Ends the game and leaves the board as it was on the fatal tick, crashed
+	// head included.
+	void handleGameOver();
+	// Plays the same game again: newGame() with the current seed.
+	void restartGame();
+	// Starts over from scratch: snake, score, tick count, food and RNG.
+	void newGame(std::uint64_t newSeed);
+
+	Snake& getSnake() { return snake; }
+	const Snake& getSnake() const { return snake; }
+	// nullptr once the snake covers the whole board.
+	const Food* getFood() const { return food; }
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	int getPoints() const { return snake.getPoints(); }
+	int getSnakeSpeed() const { return snake.getSpeed(); }
+	int getTickInterval() const;
+	bool isGameOver() const { return gameOver; }
+	long long getTicks() const { return ticks; }
+	std::uint64_t getSeed() const { return seed; }
+	Random& getRandom() { return random; }
+
+	// Hash of everything that affects future ticks, two games with equal
+	// hashes are in the same state: the snake with its pending growth and
+	// queued turns, the food, the random state and the free cell order.
+	// Input times are left out, they only measure latency. Used to compare
+	// replays bit for bit.
+	std::uint64_t stateHash() const;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+// A direction key and when it was pressed, in whatever clock the caller
+// uses (Profiler::now() in the game), 0 if nobody is timing it.
+struct InputEvent {
+	char direction;
+	std::uint64_t time;
+};
+
+//=================================================================================================
+// INPUT RING
+//=================================================================================================
+
+// Fixed size FIFO of direction events waiting for a tick to apply them, so
+// queueing input never allocates. Events pushed when it is full are dropped
+// and counted.
+class InputRing {
+public:
+	static const int capacity = 8;
+private:
+	InputEvent events[capacity];
+	int front, count;
+	std::uint64_t dropped;
+public:
+	InputRing() : front(0), count(0), dropped(0) {}
+
+	void clear() {
+		front = 0;
+		count = 0;
+	}
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	bool full() const { return count == capacity; }
+	// Events turned away by push() since construction.
+	std::uint64_t getDropped() const { return dropped; }
+
+	// Oldest and newest event, callers check empty() first.
+	const InputEvent& peek() const { return events[front]; }
+	const InputEvent& back() const { return events[(front + count - 1) % capacity]; }
+	// Oldest first, i below size().
+	const InputEvent& operator[](int i) const { return events[(front + i) % capacity]; }
+
+	bool push(const InputEvent& event) {
+		if (count == capacity) {
+			++dropped;
+			return false;
+		}
+		events[(front + count) % capacity] = event;
+		++count;
+		return true;
+	}
+
+	InputEvent pop() {
+		const InputEvent event = events[front];
+		front = (front + 1) % capacity;
+		--count;
+		return event;
+	}
+};
@@ -0,0 +1,58 @@
+#include "OccupancyGrid.h"
+
+OccupancyGrid::OccupancyGrid(int columns, int rows)
+	: columns(columns), rows(rows), stride(columns + 2), paged(false), pageColumns(0) {
+	const std::size_t cells = static_cast<std::size_t>(columns + 2) * (rows + 2);
+	if (cells > maxDenseCells) {
+		paged = true;
+		pageColumns = (columns + 63) / 64;
+		pages.assign(static_cast<std::size_t>(pageColumns) * ((rows + 63) / 64), nullptr);
+		return;
+	}
+
+	bits.assign((cells + 63) / 64, 0);
+
+	// Wall off the border so leaving the board reads as occupied.
+	auto wall = [this](int x, int y) {
+		const std::size_t i = index(x, y);
+		bits[i >> 6] |= std::uint64_t(1) << (i & 63);
+	};
+	for (int x = -1; x <= columns; ++x) {
+		wall(x, -1);
+		wall(x, rows);
+	}
+	for (int y = 0; y < rows; ++y) {
+		wall(-1, y);
+		wall(columns, y);
+	}
+}
+
+void OccupancyGrid::setPaged(int x, int y) {
+	Page*& page = pageOf(x, y);
+	if (!page) {
+		if (sparePages.empty()) {
+			pageStore.emplace_back(new Page());
+			sparePages.push_back(pageStore.back().get());
+		}
+		page = sparePages.back();
+		sparePages.pop_back();
+	}
+	const std::uint64_t bit = std::uint64_t(1) << (x & 63);
+	if (!(page->rows[y & 63] & bit)) {
+		page->rows[y & 63] |= bit;
+		++page->count;
+	}
+}
+
+void OccupancyGrid::resetPaged(int x, int y) {
+	Page*& page = pageOf(x, y);
+	const std::uint64_t bit = std::uint64_t(1) << (x & 63);
+	if (!page || !(page->rows[y & 63] & bit)) {
+		return;
+	}
+	page->rows[y & 63] &= ~bit;
+	if (--page->count == 0) {
+		sparePages.push_back(page); // all rows are zero again
+		page = nullptr;
+	}
+}
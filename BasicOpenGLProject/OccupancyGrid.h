@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//=================================================================================================
+// OCCUPANCY GRID
+//=================================================================================================
+
+// One bit per board cell, set while a snake segment is on it, and every cell
+// outside the board reads as set, so "hit a wall" and "hit the body" are the
+// same single test.
+//
+// Boards up to maxDenseCells are one bitmap surrounded by a one cell border
+// whose bits are always set. Larger boards are split into 64x64 cell pages
+// that only exist while a segment is on them; pages that empty out are kept
+// for reuse, so memory follows the snake instead of the board.
+class OccupancyGrid {
+private:
+	struct Page {
+		std::uint64_t rows[64];
+		int count; // cells set
+	};
+
+	int columns, rows;
+	int stride; // columns + 2 border cells
+	bool paged;
+
+	// Dense boards.
+	std::vector<std::uint64_t> bits;
+
+	// Paged boards.
+	int pageColumns;
+	std::vector<Page*> pages; // nullptr where no cell is set
+	std::vector<std::unique_ptr<Page>> pageStore;
+	std::vector<Page*> sparePages;
+
+	std::size_t index(int x, int y) const {
+		return static_cast<std::size_t>(y + 1) * stride + static_cast<std::size_t>(x + 1);
+	}
+	Page*& pageOf(int x, int y) { return pages[static_cast<std::size_t>(y >> 6) * pageColumns + (x >> 6)]; }
+	const Page* pageOf(int x, int y) const { return pages[static_cast<std::size_t>(y >> 6) * pageColumns + (x >> 6)]; }
+
+	bool testPaged(int x, int y) const {
+		if (!isInside(x, y)) {
+			return true;
+		}
+		const Page* page = pageOf(x, y);
+		return page && ((page->rows[y & 63] >> (x & 63)) & 1u);
+	}
+	void setPaged(int x, int y);
+	void resetPaged(int x, int y);
+public:
+	static const std::size_t maxDenseCells = std::size_t(1) << 22;
+
+	OccupancyGrid(int columns, int rows);
+
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	bool isPaged() const { return paged; }
+
+	// Raw bitboard access for bulk searches on dense boards: bit
+	// cellIndex(x, y) of words() is cell (x, y), one row is getStride() bits,
+	// and bits past cellCount() are 0.
+	const std::uint64_t* words() const { return bits.data(); }
+	std::size_t wordCount() const { return bits.size(); }
+	std::size_t cellCount() const { return static_cast<std::size_t>(stride) * (rows + 2); }
+	int getStride() const { return stride; }
+	std::size_t cellIndex(int x, int y) const { return index(x, y); }
+
+	// x and y may be anywhere from -1 to columns/rows, i.e. inside the border.
+	bool test(int x, int y) const {
+		if (paged) {
+			return testPaged(x, y);
+		}
+		const std::size_t i = index(x, y);
+		return (bits[i >> 6] >> (i & 63)) & 1u;
+	}
+	// Only cells on the board may be set and reset.
+	void set(int x, int y) {
+		if (paged) {
+			setPaged(x, y);
+			return;
+		}
+		const std::size_t i = index(x, y);
+		bits[i >> 6] |= std::uint64_t(1) << (i & 63);
+	}
+	void reset(int x, int y) {
+		if (paged) {
+			resetPaged(x, y);
+			return;
+		}
+		const std::size_t i = index(x, y);
+		bits[i >> 6] &= ~(std::uint64_t(1) << (i & 63));
+	}
+
+	bool isInside(int x, int y) const {
+		return x >= 0 && x < columns && y >= 0 && y < rows;
+	}
+
+	// Pages holding at least one cell, and pages allocated in total.
+	std::size_t getPagesInUse() const { return pageStore.size() - sparePages.size(); }
+	std::size_t getPagesAllocated() const { return pageStore.size(); }
+};
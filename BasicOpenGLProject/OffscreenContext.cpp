@@ -0,0 +1,120 @@
+#include "OffscreenContext.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <iostream>
+
+OffscreenContext::OffscreenContext()
+	: display(nullptr), context(nullptr), framebuffer(0), colorBuffer(0), depthBuffer(0), width(0), height(0) {}
+
+OffscreenContext::~OffscreenContext() {
+	destroy();
+}
+
+GLProc OffscreenContext::getProcAddress(const char* name) {
+	return reinterpret_cast<GLProc>(eglGetProcAddress(name));
+}
+
+bool OffscreenContext::create(int newWidth, int newHeight) {
+	destroy();
+
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	EGLDisplay eglDisplay = getPlatformDisplay
+		? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+		: eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr)) {
+		std::cerr << "offscreen: no EGL display\n";
+		return false;
+	}
+	display = eglDisplay;
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		std::cerr << "offscreen: EGL cannot create desktop OpenGL contexts\n";
+		destroy();
+		return false;
+	}
+
+	const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint configs = 0;
+	eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configs);
+
+	EGLContext eglContext = eglCreateContext(eglDisplay, configs > 0 ? config : nullptr, EGL_NO_CONTEXT, nullptr);
+	if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+		std::cerr << "offscreen: cannot create a surfaceless OpenGL context\n";
+		if (eglContext != EGL_NO_CONTEXT) {
+			eglDestroyContext(eglDisplay, eglContext);
+		}
+		destroy();
+		return false;
+	}
+	context = eglContext;
+
+	gl.load(getProcAddress);
+	if (!gl.hasFramebuffers()) {
+		std::cerr << "offscreen: framebuffer objects unavailable\n";
+		destroy();
+		return false;
+	}
+
+	width = newWidth;
+	height = newHeight;
+	gl.GenRenderbuffers(1, &colorBuffer);
+	gl.BindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	gl.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	gl.GenRenderbuffers(1, &depthBuffer);
+	gl.BindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	gl.RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	gl.GenFramebuffers(1, &framebuffer);
+	gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "offscreen: framebuffer incomplete\n";
+		destroy();
+		return false;
+	}
+
+	// Same setup as reshape_func() in main.cpp.
+	glViewport(0, 0, width, height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0, width, 0, height, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	return true;
+}
+
+void OffscreenContext::destroy() {
+	if (context) {
+		if (framebuffer) {
+			gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+			gl.DeleteFramebuffers(1, &framebuffer);
+		}
+		if (colorBuffer) {
+			gl.DeleteRenderbuffers(1, &colorBuffer);
+		}
+		if (depthBuffer) {
+			gl.DeleteRenderbuffers(1, &depthBuffer);
+		}
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+	}
+	if (display) {
+		eglTerminate(display);
+	}
+	display = nullptr;
+	context = nullptr;
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	width = 0;
+	height = 0;
+}
+
+void OffscreenContext::readPixels(std::vector<unsigned char>& rgb) const {
+	rgb.resize(static_cast<std::size_t>(width) * height * 3);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GLExtensions.h"
+
+#include <vector>
+
+//=================================================================================================
+// OFFSCREEN CONTEXT
+//=================================================================================================
+
+// An OpenGL compatibility context with no window: EGL on the surfaceless Mesa
+// platform, rendering into a framebuffer object. Under Mesa this runs on the
+// llvmpipe software rasterizer, so rendering can be exercised on machines
+// without a display or GPU. Linux only.
+class OffscreenContext {
+private:
+	void* display;
+	void* context;
+	GLExtensions gl;
+	GLuint framebuffer, colorBuffer, depthBuffer;
+	int width, height;
+public:
+	OffscreenContext();
+	~OffscreenContext();
+	OffscreenContext(const OffscreenContext&) = delete;
+	OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+	// Creates the context, makes it current and binds a width x height
+	// framebuffer with the same projection as the window. Prints the reason
+	// and returns false on failure.
+	bool create(int width, int height);
+	void destroy();
+
+	static GLProc getProcAddress(const char* name);
+
+	const GLExtensions& getExtensions() const { return gl; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	// Reads the framebuffer as tightly packed RGB rows, bottom row first.
+	void readPixels(std::vector<unsigned char>& rgb) const;
+};
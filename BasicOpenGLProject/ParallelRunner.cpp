@@ -0,0 +1,74 @@
+#include "ParallelRunner.h"
+#include "Bot.h"
+#include "Game.h"
+#include "Replay.h"
+
+void RunSummary::add(const GameResult& result) {
+	++games;
+	ticks += result.ticks;
+	points += result.points;
+	length += result.length;
+	if (result.points > bestPoints) {
+		bestPoints = result.points;
+	}
+	if (result.length > bestLength) {
+		bestLength = result.length;
+	}
+	if (result.won) {
+		++wins;
+	}
+}
+
+ParallelRunner::ParallelRunner(int threads, int columns, int rows, long long maxTicks)
+	: pool(threads), columns(columns), rows(rows), maxTicks(maxTicks) {
+	for (int i = 0; i < pool.getThreadCount(); ++i) {
+		games.emplace_back(new Game(columns, rows));
+		autopilots.emplace_back(new Autopilot());
+	}
+}
+
+ParallelRunner::~ParallelRunner() {}
+
+GameResult ParallelRunner::playGame(Game& game, Autopilot& autopilot, const GameJob& job, long long maxTicks,
+	Replay* recording) {
+	game.newGame(job.seed);
+	if (recording) {
+		recording->begin(game);
+	}
+
+	int length = static_cast<int>(game.getSnake().getBody().size());
+	while (!game.isGameOver() && game.getTicks() < maxTicks) {
+		// The fatal move does not count, remember the length beforehand.
+		length = static_cast<int>(game.getSnake().getBody().size());
+		char direction = 'd';
+		switch (job.policy) {
+		case Policy::Greedy:
+			direction = greedyDirection(game);
+			break;
+		case Policy::Autopilot:
+			direction = autopilot.decide(game);
+			break;
+		}
+		if (recording) {
+			recording->record(static_cast<std::uint64_t>(game.getTicks()), direction);
+		}
+		game.getSnake().setDirection(direction);
+		game.update();
+	}
+	if (!game.isGameOver()) {
+		length = static_cast<int>(game.getSnake().getBody().size());
+	}
+	if (recording) {
+		recording->finish(game);
+	}
+
+	return { job.seed, game.getPoints(), length, game.getTicks(), length == game.getColumns() * game.getRows() };
+}
+
+std::vector<GameResult> ParallelRunner::run(const std::vector<GameJob>& jobs) {
+	std::vector<GameResult> results(jobs.size());
+	pool.parallelFor(jobs.size(), [&](std::size_t i, int worker) {
+		results[i] = playGame(*games[worker], *autopilots[worker], jobs[i], maxTicks);
+	});
+	return results;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Autopilot.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Game;
+class Replay;
+
+//=================================================================================================
+// PARALLEL RUNNER
+//=================================================================================================
+
+// Who steers the snake in a headless game.
+enum class Policy {
+	Greedy,
+	Autopilot,
+};
+
+struct GameJob {
+	std::uint64_t seed;
+	Policy policy;
+};
+
+struct GameResult {
+	std::uint64_t seed;
+	int points;
+	int length;     // body length when the game ended
+	long long ticks;
+	bool won;       // the body filled the whole board
+};
+
+struct RunSummary {
+	std::size_t games = 0;
+	long long ticks = 0;
+	long long points = 0;
+	long long length = 0;
+	int bestPoints = 0;
+	int bestLength = 0;
+	std::size_t wins = 0;
+
+	void add(const GameResult& result);
+};
+
+// Plays independent games to completion on every core. Each worker thread
+// reuses its own Game between jobs and games share no mutable state, so the
+// throughput scales with the number of cores.
+class ParallelRunner {
+public:
+	// threads <= 0 uses every core. Games stop after maxTicks ticks even if
+	// the snake is still alive.
+	ParallelRunner(int threads, int columns, int rows, long long maxTicks);
+	~ParallelRunner();
+
+	int getThreadCount() const { return pool.getThreadCount(); }
+
+	// results[i] is the outcome of jobs[i].
+	std::vector<GameResult> run(const std::vector<GameJob>& jobs);
+
+	// Plays one game on the given Game object, used by the workers and by
+	// single threaded callers. autopilot steers Policy::Autopilot jobs.
+	// Optionally records the game's input.
+	static GameResult playGame(Game& game, Autopilot& autopilot, const GameJob& job, long long maxTicks,
+		Replay* recording = nullptr);
+private:
+	ThreadPool pool;
+	int columns, rows;
+	long long maxTicks;
+	std::vector<std::unique_ptr<Game>> games; // one per worker
+	std::vector<std::unique_ptr<Autopilot>> autopilots;
+};
@@ -0,0 +1,109 @@
+#include "Profiler.h"
+
+#include <cstdio>
+
+int Histogram::bucketOf(std::uint64_t value) {
+	if (value < subBuckets) {
+		return static_cast<int>(value);
+	}
+	int top = 0; // index of the highest set bit
+	for (int shift = 32; shift > 0; shift /= 2) {
+		if (value >> (top + shift)) {
+			top += shift;
+		}
+	}
+	const int sub = static_cast<int>((value >> (top - 3)) & (subBuckets - 1));
+	return (top - 2) * subBuckets + sub;
+}
+
+std::uint64_t Histogram::bucketLimit(int bucket) {
+	if (bucket < subBuckets) {
+		return static_cast<std::uint64_t>(bucket);
+	}
+	const int top = bucket / subBuckets + 2;
+	const std::uint64_t width = std::uint64_t(1) << (top - 3);
+	const std::uint64_t low = static_cast<std::uint64_t>(subBuckets + bucket % subBuckets) << (top - 3);
+	return low + width - 1;
+}
+
+void Histogram::record(std::uint64_t value) {
+	buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(value, std::memory_order_relaxed);
+	std::uint64_t seen = max.load(std::memory_order_relaxed);
+	while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+	}
+}
+
+void Histogram::reset() {
+	for (auto& bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	count.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	max.store(0, std::memory_order_relaxed);
+}
+
+double Histogram::getMean() const {
+	const std::uint64_t n = getCount();
+	return n > 0 ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+std::uint64_t Histogram::percentile(double p) const {
+	const std::uint64_t n = getCount();
+	if (n == 0) {
+		return 0;
+	}
+	// The rank of the percentile, rounded up, and at least the first value.
+	std::uint64_t rank = static_cast<std::uint64_t>(p / 100.0 * n + 0.999999);
+	rank = rank < 1 ? 1 : rank;
+	std::uint64_t seen = 0;
+	for (int bucket = 0; bucket < bucketCount; ++bucket) {
+		seen += buckets[bucket].load(std::memory_order_relaxed);
+		if (seen >= rank) {
+			const std::uint64_t limit = bucketLimit(bucket);
+			return limit < getMax() ? limit : getMax();
+		}
+	}
+	return getMax();
+}
+
+static Histogram histograms[static_cast<int>(ProfileMetric::Count)];
+
+Histogram& Profiler::histogram(ProfileMetric metric) {
+	return histograms[static_cast<int>(metric)];
+}
+
+const char* Profiler::name(ProfileMetric metric) {
+	switch (metric) {
+	case ProfileMetric::Tick: return "tick_ns";
+	case ProfileMetric::Frame: return "frame_ns";
+	case ProfileMetric::Input: return "input_ns";
+	case ProfileMetric::InputLatency: return "input_latency_ns";
+	case ProfileMetric::DrawCalls: return "draw_calls";
+	default: return "unknown";
+	}
+}
+
+void Profiler::writeJson(std::ostream& out) {
+	out << "{\n";
+	const int metrics = static_cast<int>(ProfileMetric::Count);
+	for (int i = 0; i < metrics; ++i) {
+		const ProfileMetric metric = static_cast<ProfileMetric>(i);
+		const Histogram& h = histogram(metric);
+		char line[256];
+		std::snprintf(line, sizeof(line),
+			"  \"%s\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, \"p99\": %llu, \"max\": %llu}%s\n", name(metric),
+			static_cast<unsigned long long>(h.getCount()), h.getMean(), static_cast<unsigned long long>(h.percentile(50.0)),
+			static_cast<unsigned long long>(h.percentile(99.0)), static_cast<unsigned long long>(h.getMax()),
+			i + 1 < metrics ? "," : "");
+		out << line;
+	}
+	out << "}\n";
+}
+
+void Profiler::reset() {
+	for (auto& h : histograms) {
+		h.reset();
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+//=================================================================================================
+// PROFILER
+//=================================================================================================
+
+// Fixed size histogram of non-negative values, nanoseconds for timings.
+// Buckets are a power of two split into eight, so percentiles are good to
+// about 12%. record() is a few relaxed atomic adds, any thread may record
+// while another reads.
+class Histogram {
+public:
+	static const int subBuckets = 8;
+	static const int bucketCount = 62 * subBuckets;
+
+	Histogram() { reset(); }
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+
+	void record(std::uint64_t value);
+	void reset();
+
+	std::uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+	std::uint64_t getMax() const { return max.load(std::memory_order_relaxed); }
+	double getMean() const;
+	// Upper end of the bucket holding the p-th percentile, p from 0 to 100.
+	std::uint64_t percentile(double p) const;
+private:
+	std::atomic<std::uint64_t> buckets[bucketCount];
+	std::atomic<std::uint64_t> count, sum, max;
+
+	static int bucketOf(std::uint64_t value);
+	static std::uint64_t bucketLimit(int bucket);
+};
+
+// What the game measures.
+enum class ProfileMetric {
+	Tick,         // one fixed timestep tick, ns
+	Frame,        // one redraw, ns
+	Input,        // handling one key press, ns
+	InputLatency, // from a direction key press to the tick that applies it, ns
+	DrawCalls,    // GL draw calls per frame
+	Count,
+};
+
+// The game's histograms. Use the SNAKE_PROFILE_ macros below to record, so
+// that builds without SNAKE_PROFILING compile the instrumentation out.
+class Profiler {
+public:
+	static Histogram& histogram(ProfileMetric metric);
+	static const char* name(ProfileMetric metric);
+	static bool isTime(ProfileMetric metric) { return metric != ProfileMetric::DrawCalls; }
+	static std::uint64_t now() {
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	// {"tick_ns": {"count": ..., "mean": ..., "p50": ..., "p99": ..., "max": ...}, ...}
+	static void writeJson(std::ostream& out);
+	static void reset();
+};
+
+// Records the time until the end of the enclosing scope.
+class ScopedTimer {
+private:
+	Histogram& histogram;
+	std::uint64_t start;
+public:
+	explicit ScopedTimer(ProfileMetric metric) : histogram(Profiler::histogram(metric)), start(Profiler::now()) {}
+	~ScopedTimer() { histogram.record(Profiler::now() - start); }
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#if defined(SNAKE_PROFILING)
+#define SNAKE_PROFILE_CONCAT_(a, b) a##b
+#define SNAKE_PROFILE_CONCAT(a, b) SNAKE_PROFILE_CONCAT_(a, b)
+#define SNAKE_PROFILE_SCOPE(metric) ScopedTimer SNAKE_PROFILE_CONCAT(profileTimer, __LINE__)(metric)
+#define SNAKE_PROFILE_VALUE(metric, value) Profiler::histogram(metric).record(static_cast<std::uint64_t>(value))
+#else
+#define SNAKE_PROFILE_SCOPE(metric) ((void)0)
+#define SNAKE_PROFILE_VALUE(metric, value) ((void)0)
+#endif
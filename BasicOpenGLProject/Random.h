@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+//=================================================================================================
+// RANDOM
+//=================================================================================================
+
+// Small fast PRNG (PCG32, XSH RR variant). Every Game owns one, seeded when the
+// game starts, so a seed plus the player's input reproduces a game exactly on
+// any platform, unlike rand().
+class Random {
+private:
+	std::uint64_t state;
+	std::uint64_t increment;
+public:
+	explicit Random(std::uint64_t seed = 1) { reseed(seed); }
+
+	void reseed(std::uint64_t seed) {
+		state = 0;
+		increment = (seed << 1) | 1u;
+		next();
+		state += seed;
+		next();
+	}
+
+	std::uint32_t next() {
+		const std::uint64_t old = state;
+		state = old * 6364136223846793005ULL + increment;
+		const std::uint32_t xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+		const std::uint32_t rotation = static_cast<std::uint32_t>(old >> 59u);
+		return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+	}
+
+	// Uniform in [0, bound). The multiply-shift has a bias of at most
+	// bound / 2^32, far below anything a game can notice.
+	std::uint32_t nextBelow(std::uint32_t bound) {
+		return static_cast<std::uint32_t>((static_cast<std::uint64_t>(next()) * bound) >> 32);
+	}
+
+	// Uniform in [0, 1].
+	float nextFloat() {
+		return static_cast<float>(next() >> 8) / static_cast<float>(0xFFFFFF);
+	}
+
+	std::uint64_t getState() const { return state; }
+	std::uint64_t getIncrement() const { return increment; }
+	void setState(std::uint64_t newState, std::uint64_t newIncrement) {
+		state = newState;
+		increment = newIncrement;
+	}
+};
@@ -0,0 +1,562 @@
+#include "Renderer.h"
+#include "Arena.h"
+#include "Game.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+
+namespace {
+
+const float lineWidth = 2.0f;
+const float quadSize = 30.0f;
+
+// Where a size pixel window centered on center starts along a board axis of
+// boardSize pixels, kept inside the board and on whole pixels.
+float followAxis(float center, int size, int boardSize) {
+	if (boardSize <= size) {
+		return 0.0f;
+	}
+	const float start = std::floor(center - size / 2 + 0.5f);
+	return std::min(std::max(start, 0.0f), static_cast<float>(boardSize - size));
+}
+
+} // namespace
+
+Renderer::Renderer()
+	: mode(Mode::Immediate), drawCalls(0), repaintedCells(0), gridBuffer(0), gridColumns(0), gridRows(0), gridVertices(0), quadBuffer(0), quadCapacity(0), quadCount(0),
+	frameBuffers{ 0, 0 }, frameColors{ 0, 0 }, frameIndex(0), frameWidth(0), frameHeight(0), frameValid(false), frameView(), frameColumns(0), frameRows(0),
+	frameTicks(0), frameCells(), nextView(), nextColumns(0), nextRows(0), nextTicks(0), nextCells() {}
+
+bool Renderer::init(GLProcLoader loader) {
+	gl.load(loader);
+	mode = canBatch() ? Mode::Batched : Mode::Immediate;
+	return canBatch();
+}
+
+void Renderer::release() {
+	if (gridBuffer) {
+		gl.DeleteBuffers(1, &gridBuffer);
+		gridBuffer = 0;
+	}
+	if (quadBuffer) {
+		gl.DeleteBuffers(1, &quadBuffer);
+		quadBuffer = 0;
+	}
+	gridColumns = 0;
+	gridRows = 0;
+	quadCapacity = 0;
+	releaseFrames();
+}
+
+void Renderer::setMode(Mode newMode) {
+	if (newMode == Mode::Incremental && !canDrawIncrementally()) {
+		newMode = Mode::Batched;
+	}
+	if (newMode == Mode::Batched && !canBatch()) {
+		newMode = Mode::Immediate;
+	}
+	mode = newMode;
+}
+
+const char* Renderer::getModeName(Mode mode) {
+	switch (mode) {
+	case Mode::Batched:
+		return "batched";
+	case Mode::Incremental:
+		return "incremental";
+	default:
+		return "immediate";
+	}
+}
+
+void Renderer::drawPlayfield(const Game& game, float alpha) {
+	drawPlayfield(game, alpha, boardView(game));
+}
+
+void Renderer::drawPlayfield(const Game& game, float alpha, const View& view) {
+	const CellRange cells = beginPlayfield(game.getColumns(), game.getRows(), view, game.getTicks());
+	addSnake(game.getSnake(), mode == Mode::Incremental ? 1.0f : alpha, cells);
+	if (const Food* food = game.getFood()) {
+		addFood(*food, cells);
+	}
+	endPlayfield();
+}
+
+void Renderer::drawArena(const Arena& arena, float alpha, const View& view) {
+	const CellRange cells = beginPlayfield(arena.getColumns(), arena.getRows(), view, arena.getTicks());
+	for (std::size_t i = 0; i < arena.getSnakeCount(); ++i) {
+		if (arena.isAlive(i)) {
+			addSnake(arena.getSnake(i), mode == Mode::Incremental ? 1.0f : alpha, cells);
+		}
+	}
+	for (std::size_t item = 0; item < arena.getFoodCount(); ++item) {
+		if (const Food* food = arena.getFood(item)) {
+			addFood(*food, cells);
+		}
+	}
+	endPlayfield();
+}
+
+Renderer::View Renderer::boardView(const Game& game) {
+	return boardView(game.getColumns(), game.getRows());
+}
+
+Renderer::View Renderer::boardView(int columns, int rows) {
+	return { 0.0f, 0.0f, columns * segmentSize, rows * segmentSize };
+}
+
+Renderer::View Renderer::followHead(const Game& game, float alpha, int width, int height) {
+	return followHead(game.getSnake(), game.getColumns(), game.getRows(), alpha, width, height);
+}
+
+Renderer::View Renderer::followHead(const Snake& snake, int columns, int rows, float alpha, int width, int height) {
+	const SnakeSegment& head = snake.getBody()[0];
+	const SnakeSegment& previous = snake.getPreviousPosition(0);
+	View view;
+	view.left = followAxis(cellToPixel(previous.x, head.x, alpha), width, columns * segmentSize);
+	view.bottom = followAxis(cellToPixel(previous.y, head.y, alpha), height, rows * segmentSize);
+	view.width = width;
+	view.height = height;
+	return view;
+}
+
+Renderer::CellRange Renderer::visibleCells(int columns, int rows, const View& view) {
+	CellRange cells;
+	cells.firstColumn = std::max(static_cast<int>(std::floor(view.left / segmentSize)) - 1, 0);
+	cells.lastColumn = std::min(static_cast<int>(std::floor((view.left + view.width) / segmentSize)) + 1, columns - 1);
+	cells.firstRow = std::max(static_cast<int>(std::floor(view.bottom / segmentSize)) - 1, 0);
+	cells.lastRow = std::min(static_cast<int>(std::floor((view.bottom + view.height) / segmentSize)) + 1, rows - 1);
+	// Enough cells to cover the view wherever it starts, plus the margin.
+	cells.blockColumns = std::min(columns, view.width / segmentSize + 4);
+	cells.blockRows = std::min(rows, view.height / segmentSize + 4);
+	cells.blockColumn = std::min(cells.firstColumn, columns - cells.blockColumns);
+	cells.blockRow = std::min(cells.firstRow, rows - cells.blockRows);
+	return cells;
+}
+
+// Draws the grid under the view and starts collecting quads. Incremental
+// mode only starts collecting which cell shows what.
+Renderer::CellRange Renderer::beginPlayfield(int columns, int rows, const View& view, long long ticks) {
+	drawCalls = 0;
+	quadCount = 0;
+	if (mode == Mode::Incremental && !prepareFrames(view.width, view.height)) {
+		mode = Mode::Batched;
+	}
+	const CellRange cells = visibleCells(columns, rows, view);
+	glPushMatrix();
+	glTranslatef(-view.left, -view.bottom, 0.0f);
+
+	if (mode == Mode::Incremental) {
+		prepareBuffers(cells.blockColumns, cells.blockRows);
+		nextView = view;
+		nextColumns = columns;
+		nextRows = rows;
+		nextTicks = ticks;
+		nextCells = cells;
+		nextCellColors.assign(static_cast<std::size_t>(cells.lastColumn - cells.firstColumn + 1) * (cells.lastRow - cells.firstRow + 1),
+			CellColor{ 0.0f, 0.0f, 0.0f, false });
+	}
+	else if (mode == Mode::Batched) {
+		prepareBuffers(cells.blockColumns, cells.blockRows);
+		drawGrid(cells);
+	}
+	else {
+		// visible lines only
+		glColor3f(0.0f, 0.0f, 0.0f);
+		glLineWidth(lineWidth);
+		glPushMatrix();
+		glTranslatef(static_cast<float>(cells.blockColumn * segmentSize), static_cast<float>(cells.blockRow * segmentSize), 0.0f);
+		const float left = static_cast<float>((cells.firstColumn - cells.blockColumn) * segmentSize);
+		const float right = static_cast<float>((cells.lastColumn + 1 - cells.blockColumn) * segmentSize);
+		const float bottom = static_cast<float>((cells.firstRow - cells.blockRow) * segmentSize);
+		const float top = static_cast<float>((cells.lastRow + 1 - cells.blockRow) * segmentSize);
+		for (int column = cells.firstColumn; column <= cells.lastColumn + 1; ++column) {
+			const float x = static_cast<float>((column - cells.blockColumn) * segmentSize);
+			glBegin(GL_LINES);
+			glVertex2f(x, bottom);
+			glVertex2f(x, top);
+			glEnd();
+			++drawCalls;
+		}
+		for (int row = cells.firstRow; row <= cells.lastRow + 1; ++row) {
+			const float y = static_cast<float>((row - cells.blockRow) * segmentSize);
+			glBegin(GL_LINES);
+			glVertex2f(left, y);
+			glVertex2f(right, y);
+			glEnd();
+			++drawCalls;
+		}
+		glPopMatrix();
+	}
+	return cells;
+}
+
+// The grid buffer, moved under the visible cells.
+void Renderer::drawGrid(const CellRange& cells) {
+	glColor3f(0.0f, 0.0f, 0.0f);
+	glLineWidth(lineWidth);
+	glPushMatrix();
+	glTranslatef(static_cast<float>(cells.blockColumn * segmentSize), static_cast<float>(cells.blockRow * segmentSize), 0.0f);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	gl.BindBuffer(GL_ARRAY_BUFFER, gridBuffer);
+	glVertexPointer(2, GL_FLOAT, 0, nullptr);
+	glDrawArrays(GL_LINES, 0, gridVertices);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+	glPopMatrix();
+	++drawCalls;
+}
+
+void Renderer::addSnake(const Snake& snake, float alpha, const CellRange& cells) {
+	const SegmentRing& body = snake.getBody();
+	for (std::size_t i = 0; i < body.size(); ++i) {
+		if (!isVisible(cells, body[i].x, body[i].y)) {
+			continue;
+		}
+		const SnakeSegment& previous = snake.getPreviousPosition(i);
+		addQuad(cellToPixel(previous.x, body[i].x, alpha), cellToPixel(previous.y, body[i].y, alpha),
+			snake.getRed(), snake.getGreen(), snake.getBlue());
+	}
+}
+
+void Renderer::addFood(const Food& food, const CellRange& cells) {
+	if (isVisible(cells, food.getX(), food.getY())) {
+		addQuad(cellToPixel(food.getX()), cellToPixel(food.getY()), food.getRed(), food.getGreen(), food.getBlue());
+	}
+}
+
+// Immediate mode draws the quad right away, batched mode stages it for
+// endPlayfield() and incremental mode notes the color of its cell, the last
+// quad on a cell winning as it would on screen.
+void Renderer::addQuad(float x, float y, float r, float g, float b) {
+	if (mode == Mode::Incremental) {
+		const int column = static_cast<int>(x) / segmentSize - nextCells.firstColumn;
+		const int row = static_cast<int>(y) / segmentSize - nextCells.firstRow;
+		nextCellColors[static_cast<std::size_t>(row) * (nextCells.lastColumn - nextCells.firstColumn + 1) + column] = { r, g, b, true };
+		return;
+	}
+	if (mode == Mode::Immediate) {
+		glColor3f(r, g, b);
+		glBegin(GL_QUADS);
+		glVertex2f(x - quadSize / 2, y - quadSize / 2);
+		glVertex2f(x + quadSize / 2, y - quadSize / 2);
+		glVertex2f(x + quadSize / 2, y + quadSize / 2);
+		glVertex2f(x - quadSize / 2, y + quadSize / 2);
+		glEnd();
+		++drawCalls;
+		return;
+	}
+	stageQuad(x, y, r, g, b);
+}
+
+void Renderer::endPlayfield() {
+	if (mode == Mode::Batched) {
+		uploadQuads();
+		drawQuads(0, quadCount);
+	}
+	else if (mode == Mode::Incremental) {
+		paintChangedCells();
+	}
+	glPopMatrix();
+}
+
+void Renderer::stageQuad(float x, float y, float r, float g, float b) {
+	if (quadCount == quadCapacity) {
+		return;
+	}
+	QuadVertex* v = &quads[quadCount * 4];
+	v[0] = { x - quadSize / 2, y - quadSize / 2, r, g, b };
+	v[1] = { x + quadSize / 2, y - quadSize / 2, r, g, b };
+	v[2] = { x + quadSize / 2, y + quadSize / 2, r, g, b };
+	v[3] = { x - quadSize / 2, y + quadSize / 2, r, g, b };
+	++quadCount;
+}
+
+void Renderer::uploadQuads() {
+	gl.BindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+	gl.BufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLExtensions::GLsizeiptr>(quadCount * 4 * sizeof(QuadVertex)), quads.data());
+	gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// count of the uploaded quads, from first on.
+void Renderer::drawQuads(std::size_t first, std::size_t count) {
+	gl.BindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(QuadVertex), reinterpret_cast<const void*>(offsetof(QuadVertex, x)));
+	glColorPointer(3, GL_FLOAT, sizeof(QuadVertex), reinterpret_cast<const void*>(offsetof(QuadVertex, r)));
+	glDrawArrays(GL_QUADS, static_cast<GLint>(first * 4), static_cast<GLsizei>(count * 4));
+	++drawCalls;
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Builds the static grid buffer for a block of columns x rows cells and
+// sizes the dynamic quad buffer to match, only when the block size changes.
+void Renderer::prepareBuffers(int columns, int rows) {
+	if (columns == gridColumns && rows == gridRows) {
+		return;
+	}
+	gridColumns = columns;
+	gridRows = rows;
+
+	const float width = static_cast<float>(columns * segmentSize);
+	const float height = static_cast<float>(rows * segmentSize);
+	std::vector<float> lines;
+	lines.reserve(static_cast<std::size_t>(columns + rows + 2) * 4);
+	for (int x = 0; x <= columns; ++x) {
+		const float px = static_cast<float>(x * segmentSize);
+		lines.insert(lines.end(), { px, 0.0f, px, height });
+	}
+	for (int y = 0; y <= rows; ++y) {
+		const float py = static_cast<float>(y * segmentSize);
+		lines.insert(lines.end(), { 0.0f, py, width, py });
+	}
+	gridVertices = static_cast<GLsizei>(lines.size() / 2);
+
+	if (!gridBuffer) {
+		gl.GenBuffers(1, &gridBuffer);
+	}
+	gl.BindBuffer(GL_ARRAY_BUFFER, gridBuffer);
+	gl.BufferData(GL_ARRAY_BUFFER, static_cast<GLExtensions::GLsizeiptr>(lines.size() * sizeof(float)), lines.data(), GL_STATIC_DRAW);
+
+	// Every cell of the block covered by a snake or food, plus a crashed
+	// head on top of the body.
+	quadCapacity = static_cast<std::size_t>(columns) * rows + 1;
+	quads.resize(quadCapacity * 4);
+	// and what incremental mode notes down per cell, so frames allocate nothing
+	nextCellColors.reserve(quadCapacity);
+	frameCellColors.reserve(quadCapacity);
+	changedRects.reserve(quadCapacity);
+	if (!quadBuffer) {
+		gl.GenBuffers(1, &quadBuffer);
+	}
+	gl.BindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+	gl.BufferData(GL_ARRAY_BUFFER, static_cast<GLExtensions::GLsizeiptr>(quads.size() * sizeof(QuadVertex)), nullptr, GL_DYNAMIC_DRAW);
+	gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//=================================================================================================
+// INCREMENTAL
+//=================================================================================================
+
+// Sizes both frame buffers to the view, which loses what they held. False,
+// without frame buffers, if they cannot be made.
+bool Renderer::prepareFrames(int width, int height) {
+	if (frameBuffers[0] && width == frameWidth && height == frameHeight) {
+		return true;
+	}
+	frameValid = false;
+	GLint drawTarget = 0, readTarget = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawTarget);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readTarget);
+	if (!frameBuffers[0]) {
+		gl.GenRenderbuffers(2, frameColors);
+		gl.GenFramebuffers(2, frameBuffers);
+	}
+	bool complete = true;
+	for (int i = 0; i < 2; ++i) {
+		gl.BindRenderbuffer(GL_RENDERBUFFER, frameColors[i]);
+		gl.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		gl.BindFramebuffer(GL_FRAMEBUFFER, frameBuffers[i]);
+		gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, frameColors[i]);
+		complete = complete && gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+	gl.BindRenderbuffer(GL_RENDERBUFFER, 0);
+	gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(drawTarget));
+	gl.BindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(readTarget));
+	if (!complete) {
+		releaseFrames();
+		return false;
+	}
+	frameWidth = width;
+	frameHeight = height;
+	return true;
+}
+
+void Renderer::releaseFrames() {
+	if (frameBuffers[0]) {
+		gl.DeleteFramebuffers(2, frameBuffers);
+		gl.DeleteRenderbuffers(2, frameColors);
+		frameBuffers[0] = frameBuffers[1] = 0;
+		frameColors[0] = frameColors[1] = 0;
+	}
+	frameWidth = 0;
+	frameHeight = 0;
+	frameValid = false;
+}
+
+bool Renderer::wasDrawn(int column, int row) const {
+	// The part of the cell inside the view, in board pixels, must have been
+	// inside the last frame's view too.
+	const int left = std::max(column * segmentSize, static_cast<int>(nextView.left));
+	const int right = std::min((column + 1) * segmentSize, static_cast<int>(nextView.left) + frameWidth);
+	const int bottom = std::max(row * segmentSize, static_cast<int>(nextView.bottom));
+	const int top = std::min((row + 1) * segmentSize, static_cast<int>(nextView.bottom) + frameHeight);
+	const int frameLeft = static_cast<int>(frameView.left);
+	const int frameBottom = static_cast<int>(frameView.bottom);
+	if (left < frameLeft || right > frameLeft + frameWidth || bottom < frameBottom || top > frameBottom + frameHeight) {
+		return false;
+	}
+	// Whether a grid line right on the edge of the view is drawn comes down
+	// to rounding, so it can differ from one inside the view: once the view
+	// scrolls, the cells bordering its old or new edges are repainted.
+	const int viewLeft = static_cast<int>(nextView.left);
+	const int viewBottom = static_cast<int>(nextView.bottom);
+	if (frameLeft != viewLeft || frameBottom != viewBottom) {
+		const int cellLeft = column * segmentSize;
+		const int cellBottom = row * segmentSize;
+		for (int edge : { frameLeft, frameLeft + frameWidth, viewLeft, viewLeft + frameWidth }) {
+			if (cellLeft == edge || cellLeft + segmentSize == edge) {
+				return false;
+			}
+		}
+		for (int edge : { frameBottom, frameBottom + frameHeight, viewBottom, viewBottom + frameHeight }) {
+			if (cellBottom == edge || cellBottom + segmentSize == edge) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Brings the frame buffer up to the cells collected since beginPlayfield()
+// and copies it into the framebuffer that was bound.
+void Renderer::paintChangedCells() {
+	GLint drawTarget = 0, readTarget = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawTarget);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readTarget);
+	const int viewLeft = static_cast<int>(nextView.left);
+	const int viewBottom = static_cast<int>(nextView.bottom);
+
+	bool full = !frameValid || nextColumns != frameColumns || nextRows != frameRows || nextTicks < frameTicks;
+	const int dx = viewLeft - static_cast<int>(frameView.left);
+	const int dy = viewBottom - static_cast<int>(frameView.bottom);
+	if (!full && (dx != 0 || dy != 0)) {
+		if (std::abs(dx) >= frameWidth || std::abs(dy) >= frameHeight) {
+			full = true;
+		}
+		else {
+			// Scrolled: what is still in view goes where it now shows, in
+			// the other buffer.
+			const int left = std::max(dx, 0), right = frameWidth + std::min(dx, 0);
+			const int bottom = std::max(dy, 0), top = frameHeight + std::min(dy, 0);
+			gl.BindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffers[frameIndex]);
+			gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, frameBuffers[1 - frameIndex]);
+			gl.BlitFramebuffer(left, bottom, right, top, left - dx, bottom - dy, right - dx, top - dy, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			++drawCalls;
+			frameIndex = 1 - frameIndex;
+		}
+	}
+	gl.BindFramebuffer(GL_FRAMEBUFFER, frameBuffers[frameIndex]);
+
+	// The cells to paint, as runs along each row merged with the same run on
+	// the row below, so a row or column scrolled in is one rectangle.
+	changedRects.clear();
+	repaintedCells = 0;
+	const int columns = nextCells.lastColumn - nextCells.firstColumn + 1;
+	const int frameColumnCount = frameCells.lastColumn - frameCells.firstColumn + 1;
+	const int firstColumn = std::max(nextCells.firstColumn, viewLeft / segmentSize);
+	const int lastColumn = std::min(nextCells.lastColumn, (viewLeft + frameWidth - 1) / segmentSize);
+	const int firstRow = std::max(nextCells.firstRow, viewBottom / segmentSize);
+	const int lastRow = std::min(nextCells.lastRow, (viewBottom + frameHeight - 1) / segmentSize);
+	for (int row = firstRow; row <= lastRow; ++row) {
+		for (int column = firstColumn; column <= lastColumn; ++column) {
+			const int index = (row - nextCells.firstRow) * columns + column - nextCells.firstColumn;
+			if (full) {
+				const CellColor& color = nextCellColors[index];
+				if (color.filled) {
+					stageQuad(cellToPixel(column), cellToPixel(row), color.r, color.g, color.b);
+				}
+				++repaintedCells;
+				continue;
+			}
+			if (wasDrawn(column, row)
+				&& nextCellColors[index] == frameCellColors[(row - frameCells.firstRow) * frameColumnCount + column - frameCells.firstColumn]) {
+				continue;
+			}
+			if (column > firstColumn && !changedRects.empty() && changedRects.back().row == row
+				&& changedRects.back().column + changedRects.back().columns == column) {
+				++changedRects.back().columns;
+			}
+			else {
+				changedRects.push_back({ column, row, 1, 1, 0, 0 });
+			}
+			++repaintedCells;
+		}
+		// This row's runs, from the back, onto the rectangle right below
+		// each if it spans the same columns.
+		std::size_t rowStart = changedRects.size();
+		while (rowStart > 0 && changedRects[rowStart - 1].row == row) {
+			--rowStart;
+		}
+		for (std::size_t run = rowStart; run < changedRects.size();) {
+			const CellRect& cells = changedRects[run];
+			std::size_t below = 0;
+			while (below < rowStart && !(changedRects[below].row + changedRects[below].rows == row
+				&& changedRects[below].column == cells.column && changedRects[below].columns == cells.columns)) {
+				++below;
+			}
+			if (below < rowStart) {
+				++changedRects[below].rows;
+				changedRects.erase(changedRects.begin() + run);
+			}
+			else {
+				++run;
+			}
+		}
+	}
+
+	if (full) {
+		glClear(GL_COLOR_BUFFER_BIT);
+		drawGrid(nextCells);
+		uploadQuads();
+		drawQuads(0, quadCount);
+	}
+	else if (!changedRects.empty()) {
+		for (CellRect& cells : changedRects) {
+			cells.firstQuad = quadCount;
+			for (int row = cells.row; row < cells.row + cells.rows; ++row) {
+				for (int column = cells.column; column < cells.column + cells.columns; ++column) {
+					const CellColor& color = nextCellColors[(row - nextCells.firstRow) * columns + column - nextCells.firstColumn];
+					if (color.filled) {
+						stageQuad(cellToPixel(column), cellToPixel(row), color.r, color.g, color.b);
+					}
+				}
+			}
+			cells.quadCount = quadCount - cells.firstQuad;
+		}
+		// Each cell owns its square, grid lines included: clearing it and
+		// drawing the grid and its quads over it gives the pixels a full
+		// redraw would.
+		uploadQuads();
+		glEnable(GL_SCISSOR_TEST);
+		for (const CellRect& cells : changedRects) {
+			glScissor(cells.column * segmentSize - viewLeft, cells.row * segmentSize - viewBottom,
+				cells.columns * segmentSize, cells.rows * segmentSize);
+			glClear(GL_COLOR_BUFFER_BIT);
+			drawGrid(nextCells);
+			if (cells.quadCount > 0) {
+				drawQuads(cells.firstQuad, cells.quadCount);
+			}
+		}
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	gl.BindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffers[frameIndex]);
+	gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(drawTarget));
+	gl.BlitFramebuffer(0, 0, frameWidth, frameHeight, 0, 0, frameWidth, frameHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	++drawCalls;
+	gl.BindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(readTarget));
+
+	frameValid = true;
+	frameView = nextView;
+	frameColumns = nextColumns;
+	frameRows = nextRows;
+	frameTicks = nextTicks;
+	frameCells = nextCells;
+	frameCellColors.swap(nextCellColors);
+}
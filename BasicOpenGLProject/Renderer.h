@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Board.h"
+#include "GLExtensions.h"
+
+#include <vector>
+
+class Arena;
+class Food;
+class Game;
+class Snake;
+
+//=================================================================================================
+// RENDERER
+//=================================================================================================
+
+// Draws the playfield (grid, snakes and food) of a Game or an Arena into the
+// current GL context, in pixels with the origin at the bottom left. Knows nothing about
+// GLUT so it can also draw into an offscreen context.
+//
+// Batched mode keeps the grid in a static vertex buffer uploaded once per
+// board size and streams every snake segment and the food into one dynamic
+// buffer, for two draw calls per frame whatever the snake lengths. Immediate
+// mode is the original glBegin/glEnd path, one draw call per grid line and
+// per quad, used when buffer objects are unavailable.
+//
+// Only the cells inside a View are drawn, so boards far larger than the
+// window cost what the visible part costs: the grid buffer covers a block
+// of cells the size of the view that is moved under it, and segments
+// outside the view are skipped.
+//
+// Incremental mode keeps the playfield as last drawn in a framebuffer object
+// of the view's size and only repaints the cells that changed since, in
+// rectangles scissored to them and redrawn as batched mode would (cells own
+// their square, grid lines included, so nothing else is touched), then
+// copies the whole of it into the current framebuffer. A tick of a lone
+// snake is a handful of cells whatever the board. When the view scrolls
+// the old picture is copied across first and the cells scrolled in are
+// repainted; a view of a new size, a different board, ticks going
+// backwards (a new game, a rewind) or invalidate() redraw everything.
+// Segments are always drawn on their cells, alpha is ignored: sliding them
+// between cells would change every cell every frame.
+class Renderer {
+public:
+	enum class Mode { Immediate, Batched, Incremental };
+
+	// The part of the board shown, in board pixels from the bottom left.
+	struct View {
+		float left, bottom;
+		int width, height;
+	};
+
+	static const int segmentSize = DefaultBoard::cellSize;
+
+	Renderer();
+
+	// Looks up buffer object entry points; a context must be current. Returns
+	// false, and stays in Immediate mode, if buffer objects are unavailable.
+	bool init(GLProcLoader loader);
+	// Frees the GL objects, call while the context is still current.
+	void release();
+
+	bool canBatch() const { return gl.hasBuffers(); }
+	bool canDrawIncrementally() const { return canBatch() && gl.hasBlit(); }
+	// Falls back to the next mode down that is available.
+	void setMode(Mode newMode);
+	Mode getMode() const { return mode; }
+	static const char* getModeName(Mode mode);
+
+	// The next incremental frame redraws every cell, e.g. after a change of
+	// clear color, which the renderer cannot see.
+	void invalidate() { frameValid = false; }
+
+	// alpha is how far the game is between its last tick and the next one,
+	// segments are drawn that far along from their previous cell to their
+	// current one. 1 draws exactly the current state.
+	void drawPlayfield(const Game& game, float alpha = 1.0f);
+	void drawPlayfield(const Game& game, float alpha, const View& view);
+	// Every snake still in the arena and every food item on the board.
+	void drawArena(const Arena& arena, float alpha, const View& view);
+
+	// The whole board.
+	static View boardView(const Game& game);
+	static View boardView(int columns, int rows);
+	// A width x height window onto the board centered on the interpolated
+	// head, kept inside the board. Axes where the board fits show all of it.
+	static View followHead(const Game& game, float alpha, int width, int height);
+	static View followHead(const Snake& snake, int columns, int rows, float alpha, int width, int height);
+
+	// Draw calls issued by the last drawPlayfield() or drawArena(), the
+	// copies of incremental mode included.
+	int getDrawCalls() const { return drawCalls; }
+	// Cells the last incremental frame repainted, every one in view when it
+	// redrew everything.
+	int getRepaintedCells() const { return repaintedCells; }
+
+	static float cellToPixel(int cell) {
+		return static_cast<float>(cell * segmentSize + segmentSize / 2);
+	}
+	static float cellToPixel(int previous, int current, float alpha) {
+		const float from = cellToPixel(previous);
+		return from + (cellToPixel(current) - from) * alpha;
+	}
+private:
+	struct QuadVertex {
+		float x, y;
+		float r, g, b;
+	};
+
+	// What one cell of an incremental frame shows.
+	struct CellColor {
+		float r, g, b;
+		bool filled;
+
+		bool operator==(const CellColor& other) const {
+			return filled == other.filled && r == other.r && g == other.g && b == other.b;
+		}
+	};
+
+	// Cells repainted together, and their quads among the staged ones.
+	struct CellRect {
+		int column, row;
+		int columns, rows;
+		std::size_t firstQuad, quadCount;
+	};
+
+	GLExtensions gl;
+	Mode mode;
+	int drawCalls;
+	int repaintedCells;
+
+	// Visible cells, inclusive, one cell of margin for segments moving in,
+	// and the block of cells the grid is drawn for. Both paths draw the grid
+	// relative to the block so lines land on the same pixels.
+	struct CellRange {
+		int firstColumn, lastColumn;
+		int firstRow, lastRow;
+		int blockColumn, blockRow;
+		int blockColumns, blockRows;
+	};
+
+	GLuint gridBuffer;
+	int gridColumns, gridRows; // cells covered by the grid buffer
+	GLsizei gridVertices;
+
+	GLuint quadBuffer;
+	std::vector<QuadVertex> quads; // CPU staging, sized once per grid block
+	std::size_t quadCapacity;
+	std::size_t quadCount; // staged since beginPlayfield()
+
+	// Incremental mode. frameBuffers[frameIndex] holds the last frame; the
+	// other is what scrolling copies it into.
+	GLuint frameBuffers[2];
+	GLuint frameColors[2];
+	int frameIndex;
+	int frameWidth, frameHeight;
+	bool frameValid;
+	View frameView;
+	int frameColumns, frameRows;
+	long long frameTicks;
+	CellRange frameCells;
+	std::vector<CellColor> frameCellColors; // frameCells, row by row
+	// The frame being drawn, between beginPlayfield() and endPlayfield().
+	View nextView;
+	int nextColumns, nextRows;
+	long long nextTicks;
+	CellRange nextCells;
+	std::vector<CellColor> nextCellColors;
+	std::vector<CellRect> changedRects;
+
+	static CellRange visibleCells(int columns, int rows, const View& view);
+	static bool isVisible(const CellRange& cells, int x, int y) {
+		return x >= cells.firstColumn && x <= cells.lastColumn && y >= cells.firstRow && y <= cells.lastRow;
+	}
+
+	// Both draw functions draw the grid, add every visible quad, then end,
+	// which in batched mode is when the quads are drawn and in incremental
+	// mode when the changed cells are. ticks tells a new game apart.
+	CellRange beginPlayfield(int columns, int rows, const View& view, long long ticks);
+	void addSnake(const Snake& snake, float alpha, const CellRange& cells);
+	void addFood(const Food& food, const CellRange& cells);
+	void addQuad(float x, float y, float r, float g, float b);
+	void endPlayfield();
+	void prepareBuffers(int columns, int rows);
+	void drawGrid(const CellRange& cells);
+	void stageQuad(float x, float y, float r, float g, float b);
+	void uploadQuads();
+	void drawQuads(std::size_t first, std::size_t count);
+
+	bool prepareFrames(int width, int height);
+	void releaseFrames();
+	void paintChangedCells();
+	// Whether the cell's visible part was inside the last frame, given the
+	// copy made for scrolling.
+	bool wasDrawn(int column, int row) const;
+};
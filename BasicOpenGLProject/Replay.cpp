@@ -0,0 +1,175 @@
+#include "Replay.h"
+#include "Game.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char magic[4] = { 'S', 'N', 'K', 'R' };
+const char directionKeys[4] = { 'w', 'a', 's', 'd' };
+
+int directionIndex(char direction) {
+	for (int i = 0; i < 4; ++i) {
+		if (directionKeys[i] == direction) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void putFixed(std::vector<unsigned char>& out, std::uint64_t value, int bytes) {
+	for (int i = 0; i < bytes; ++i) {
+		out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+}
+
+void putVarint(std::vector<unsigned char>& out, std::uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+// Reads from a byte buffer, any read past the end sets ok to false.
+struct Reader {
+	const std::vector<unsigned char>& data;
+	std::size_t position;
+	bool ok;
+
+	std::uint64_t fixed(int bytes) {
+		if (position + bytes > data.size()) {
+			ok = false;
+			return 0;
+		}
+		std::uint64_t value = 0;
+		for (int i = 0; i < bytes; ++i) {
+			value |= static_cast<std::uint64_t>(data[position++]) << (8 * i);
+		}
+		return value;
+	}
+
+	std::uint64_t varint() {
+		std::uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (position >= data.size()) {
+				break;
+			}
+			const unsigned char byte = data[position++];
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return value;
+			}
+		}
+		ok = false;
+		return 0;
+	}
+};
+
+} // namespace
+
+Replay::Replay() : columns(0), rows(0), seed(0), endTick(0), endHash(0), nextEvent(0) {}
+
+void Replay::begin(const Game& game) {
+	columns = game.getColumns();
+	rows = game.getRows();
+	seed = game.getSeed();
+	events.clear();
+	events.reserve(4096); // keeps recording off the heap in normal games
+	endTick = 0;
+	endHash = 0;
+	nextEvent = 0;
+}
+
+void Replay::record(std::uint64_t tick, char direction) {
+	if (directionIndex(direction) >= 0) {
+		events.push_back({ tick, direction });
+	}
+}
+
+void Replay::finish(const Game& game) {
+	endTick = static_cast<std::uint64_t>(game.getTicks());
+	endHash = game.stateHash();
+}
+
+bool Replay::apply(Game& game) {
+	const std::uint64_t tick = static_cast<std::uint64_t>(game.getTicks());
+	while (nextEvent < events.size() && events[nextEvent].tick <= tick) {
+		game.getSnake().setDirection(events[nextEvent].direction);
+		++nextEvent;
+	}
+	return tick < endTick;
+}
+
+bool Replay::save(const std::string& path) const {
+	std::vector<unsigned char> out(magic, magic + sizeof(magic));
+	putFixed(out, version, 1);
+	putFixed(out, static_cast<std::uint64_t>(columns), 2);
+	putFixed(out, static_cast<std::uint64_t>(rows), 2);
+	putFixed(out, seed, 8);
+
+	putVarint(out, events.size());
+	std::uint64_t previousTick = 0;
+	for (const Event& event : events) {
+		putVarint(out, ((event.tick - previousTick) << 2) | static_cast<std::uint64_t>(directionIndex(event.direction)));
+		previousTick = event.tick;
+	}
+	putVarint(out, endTick);
+	putFixed(out, endHash, 8);
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+	return static_cast<bool>(file);
+}
+
+bool Replay::load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	const std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() < sizeof(magic) || std::memcmp(data.data(), magic, sizeof(magic)) != 0) {
+		return false;
+	}
+
+	Reader in = { data, sizeof(magic), true };
+	if (in.fixed(1) != version) {
+		return false;
+	}
+	const int newColumns = static_cast<int>(in.fixed(2));
+	const int newRows = static_cast<int>(in.fixed(2));
+	const std::uint64_t newSeed = in.fixed(8);
+	// Nothing a front end accepts on its command line, no game to play back.
+	if (newColumns < 1 || newColumns > Game::maxBoardSize || newRows < 1 || newRows > Game::maxBoardSize) {
+		return false;
+	}
+
+	const std::uint64_t count = in.varint();
+	if (!in.ok || count > data.size()) {
+		return false;
+	}
+	std::vector<Event> newEvents;
+	newEvents.reserve(static_cast<std::size_t>(count));
+	std::uint64_t tick = 0;
+	for (std::uint64_t i = 0; i < count && in.ok; ++i) {
+		const std::uint64_t packed = in.varint();
+		tick += packed >> 2;
+		newEvents.push_back({ tick, directionKeys[packed & 3] });
+	}
+	const std::uint64_t newEndTick = in.varint();
+	const std::uint64_t newEndHash = in.fixed(8);
+	if (!in.ok) {
+		return false;
+	}
+
+	columns = newColumns;
+	rows = newRows;
+	seed = newSeed;
+	events.swap(newEvents);
+	endTick = newEndTick;
+	endHash = newEndHash;
+	nextEvent = 0;
+	return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Game;
+
+//=================================================================================================
+// REPLAY
+//=================================================================================================
+
+// A recorded game: the board size and seed it started from plus every
+// direction key, stamped with the number of ticks completed when it was
+// pressed. Feeding the same keys to a Game started with the same seed on the
+// same ticks reproduces it exactly, at any speed.
+//
+// File format, integers little endian:
+//   "SNKR" u8 version  u16 columns  u16 rows  u64 seed
+//   varint eventCount, then per event varint((tickDelta << 2) | direction)
+//   varint endTick  u64 endHash
+// direction is 0..3 for w, a, s, d and tickDelta counts from the previous
+// event, so a typical key press takes one or two bytes.
+class Replay {
+public:
+	struct Event {
+		std::uint64_t tick;
+		char direction;
+	};
+
+	// 2: food spawns only on free cells, which draws different random numbers.
+	// 3: game over leaves the crashed snake on the board, so the end hash
+	// changed.
+	// 4: the end hash covers pending growth, queued turns and the free cell
+	// order.
+	static const std::uint8_t version = 4;
+
+	Replay();
+
+	// Recording
+	void begin(const Game& game);
+	void record(std::uint64_t tick, char direction);
+	void finish(const Game& game);
+
+	// Playback: call before every Game::update(), passes the keys for the
+	// coming tick to the snake. Returns false once the recording has ended.
+	bool apply(Game& game);
+	void rewind() { nextEvent = 0; }
+
+	bool save(const std::string& path) const;
+	// False, leaving the replay as it was, for a file that is unreadable,
+	// of another version, or for a board outside 1..Game::maxBoardSize.
+	bool load(const std::string& path);
+
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	std::uint64_t getSeed() const { return seed; }
+	std::uint64_t getEndTick() const { return endTick; }
+	std::uint64_t getEndHash() const { return endHash; }
+	const std::vector<Event>& getEvents() const { return events; }
+private:
+	int columns, rows;
+	std::uint64_t seed;
+	std::vector<Event> events;
+	std::uint64_t endTick;
+	std::uint64_t endHash;
+	std::size_t nextEvent;
+};
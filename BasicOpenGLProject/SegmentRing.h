@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+struct SnakeSegment {
+	int x, y;
+};
+
+//=================================================================================================
+// SEGMENT RING
+//=================================================================================================
+
+// Ring buffer holding the snake's body, head first, up to capacity() segments
+// (one per board cell). Pushing a new head and dropping the tail are O(1).
+// Storage for the first initialSlots segments is allocated up front, so on
+// boards up to that many cells the ring never touches the heap again; on
+// larger boards it doubles as the snake grows, keeping memory in proportion
+// to the snake rather than the board.
+class SegmentRing {
+private:
+	std::vector<SnakeSegment> slots;
+	std::size_t head; // index of the head segment
+	std::size_t count;
+	std::size_t maxCount;
+
+	// Moves the segments to a larger vector, head first from slot 0.
+	void grow() {
+		std::vector<SnakeSegment> larger(slots.size() * 2 < maxCount ? slots.size() * 2 : maxCount);
+		for (std::size_t i = 0; i < count; ++i) {
+			larger[i] = (*this)[i];
+		}
+		slots.swap(larger);
+		head = 0;
+	}
+
+	std::size_t wrap(std::size_t index) const {
+		return index >= slots.size() ? index - slots.size() : index;
+	}
+public:
+	class const_iterator {
+	private:
+		const SegmentRing* ring;
+		std::size_t offset;
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = SnakeSegment;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const SnakeSegment*;
+		using reference = const SnakeSegment&;
+
+		const_iterator(const SegmentRing* ring, std::size_t offset) : ring(ring), offset(offset) {}
+
+		reference operator*() const { return (*ring)[offset]; }
+		pointer operator->() const { return &(*ring)[offset]; }
+		const_iterator& operator++() { ++offset; return *this; }
+		const_iterator operator++(int) { const_iterator old = *this; ++offset; return old; }
+		bool operator==(const const_iterator& other) const { return offset == other.offset; }
+		bool operator!=(const const_iterator& other) const { return offset != other.offset; }
+	};
+
+	static const std::size_t initialSlots = 4096;
+
+	explicit SegmentRing(std::size_t capacity)
+		: slots(capacity == 0 ? 1 : capacity < initialSlots ? capacity : initialSlots), head(0), count(0),
+		maxCount(capacity > 0 ? capacity : 1) {}
+
+	std::size_t size() const { return count; }
+	std::size_t capacity() const { return maxCount; }
+	bool empty() const { return count == 0; }
+	bool full() const { return count == maxCount; }
+
+	// 0 is the head, size() - 1 is the tail.
+	const SnakeSegment& operator[](std::size_t i) const { return slots[wrap(head + i)]; }
+	const SnakeSegment& front() const { return slots[head]; }
+	const SnakeSegment& back() const { return slots[wrap(head + count - 1)]; }
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, count); }
+
+	void clear() {
+		head = 0;
+		count = 0;
+	}
+
+	// Callers check full() first.
+	void push_front(const SnakeSegment& segment) {
+		if (count == slots.size()) {
+			grow();
+		}
+		head = head == 0 ? slots.size() - 1 : head - 1;
+		slots[head] = segment;
+		++count;
+	}
+
+	void push_back(const SnakeSegment& segment) {
+		if (count == slots.size()) {
+			grow();
+		}
+		slots[wrap(head + count)] = segment;
+		++count;
+	}
+
+	void pop_back() {
+		--count;
+	}
+};
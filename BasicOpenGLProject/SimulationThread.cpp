@@ -0,0 +1,85 @@
+#include "SimulationThread.h"
+
+#include "Game.h"
+
+#include <algorithm>
+
+SimulationThread::SimulationThread(Game& game, CommandHandler handleCommand, TickHandler tick)
+	: game(game), handleCommand(handleCommand), tick(tick), tickMs(0), commands(commandCapacity),
+	frames(Frame{ Snapshot(Snapshot::maxSize(game.getColumns(), game.getRows())), Clock::time_point(), 1.0f, game.getTickInterval(), 0 }),
+	published(0), stopping(false), running(false), ticks(0), commandsHandled(0) {}
+
+SimulationThread::~SimulationThread() {
+	stop();
+}
+
+void SimulationThread::start() {
+	stop();
+	timestep.reset();
+	publish();
+	stopping.store(false, std::memory_order_relaxed);
+	running.store(true, std::memory_order_release);
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+	stopping.store(true, std::memory_order_release);
+	if (thread.joinable()) {
+		thread.join();
+	}
+	running.store(false, std::memory_order_release);
+}
+
+float SimulationThread::getAlpha(Clock::time_point now) const {
+	const Frame& frame = getFrame();
+	if (frame.tickInterval <= 0) {
+		return 1.0f;
+	}
+	const double elapsedMs = std::chrono::duration<double, std::milli>(now - frame.published).count();
+	return std::min(1.0f, frame.alpha + static_cast<float>(elapsedMs / frame.tickInterval));
+}
+
+void SimulationThread::run() {
+	while (!stopping.load(std::memory_order_acquire)) {
+		bool changed = false;
+		Command command;
+		while (commands.pop(command)) {
+			handleCommand(game, command);
+			commandsHandled.fetch_add(1, std::memory_order_relaxed);
+			changed = true;
+		}
+
+		const int interval = tickMs > 0 ? tickMs : game.getTickInterval();
+		const int due = timestep.advance(interval);
+		bool ended = false;
+		for (int i = 0; i < due && !ended; ++i) {
+			ended = !tick(game, timestep);
+			ticks.fetch_add(1, std::memory_order_relaxed);
+			changed = true;
+		}
+		if (changed) {
+			publish();
+		}
+		if (ended) {
+			break;
+		}
+
+		// Sleep until the next tick is due, but look for commands at least
+		// once a millisecond.
+		if (due == 0) {
+			const std::chrono::duration<double, std::milli> untilTick((1.0f - timestep.getAlpha()) * interval);
+			std::this_thread::sleep_for(std::min(untilTick, std::chrono::duration<double, std::milli>(1.0)));
+		}
+	}
+	running.store(false, std::memory_order_release);
+}
+
+void SimulationThread::publish() {
+	Frame& frame = frames.getBack();
+	frame.state.capture(game, Snapshot::Contents::Display);
+	frame.published = Clock::now();
+	frame.alpha = timestep.getAlpha();
+	frame.tickInterval = tickMs > 0 ? tickMs : game.getTickInterval();
+	frame.sequence = ++published;
+	frames.publish();
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "FixedTimestep.h"
+#include "Snapshot.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+class Game;
+
+//=================================================================================================
+// SIMULATION THREAD
+//=================================================================================================
+
+// Runs a Game's ticks on a thread of its own, on a FixedTimestep, so a slow
+// frame never delays a tick and a slow tick never delays a frame.
+//
+// Nothing is shared with the game but two lock free channels. The input
+// thread post()s commands (key presses) over an SpscQueue; the simulation
+// thread carries them out before its next tick. After every tick, or
+// command, it captures the game into a Display Snapshot and publishes it
+// through a TripleBuffer, from which the render thread acquire()s the newest
+// one and restores it into a Game of its own, made without a free cell
+// index, to draw. Neither side copies more than the snake, whatever the
+// board. Once start()ed the game belongs to the simulation thread until
+// stop().
+class SimulationThread {
+public:
+	typedef FixedTimestep::Clock Clock;
+
+	// Something the input thread wants done to the game, a key press for
+	// the command handler to interpret.
+	struct Command {
+		char key;
+		std::uint64_t time; // when it happened, as InputEvent has it
+	};
+
+	// The game as of the latest tick.
+	struct Frame {
+		Snapshot state; // Snapshot::Contents::Display
+		Clock::time_point published;
+		float alpha;      // the timestep's, when published
+		int tickInterval; // ms, the pace the ticks are running at
+		long long sequence; // 1 for the first frame published
+	};
+
+	// Both run on the simulation thread. tick does one whole tick,
+	// Game::update() and whatever goes with it, and returns false to end
+	// the thread. It is handed the thread's timestep rather than reaching
+	// for it, the SimulationThread may be on its way out.
+	typedef std::function<void(Game& game, const Command& command)> CommandHandler;
+	typedef std::function<bool(Game& game, FixedTimestep& timestep)> TickHandler;
+
+	static const std::size_t commandCapacity = 64;
+
+	SimulationThread(Game& game, CommandHandler handleCommand, TickHandler tick);
+	~SimulationThread();
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// Ticks every tickMs milliseconds, 0 (the default) at the game's own
+	// tick interval. Call before start().
+	void setTickMs(int ms) { tickMs = ms; }
+
+	// Publishes the game as it is and starts ticking it.
+	void start();
+	// Asks the thread to stop after the tick it is on and waits for it.
+	void stop();
+	// False once the tick handler ended the thread, or after stop().
+	bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+	// Input thread. False, dropping the command, if the queue is full.
+	bool post(const Command& command) { return commands.push(command); }
+
+	// Render thread. True if a frame newer than getFrame() was published,
+	// which getFrame() then is.
+	bool acquire() { return frames.acquire(); }
+	const Frame& getFrame() const { return frames.getFront(); }
+	// How far the game is from the frame's tick to the next at now, for
+	// drawing between ticks.
+	float getAlpha(Clock::time_point now) const;
+
+	// Simulation thread, from the handlers, or any thread after stop().
+	FixedTimestep& getTimestep() { return timestep; }
+	// Any thread.
+	long long getTicks() const { return ticks.load(std::memory_order_relaxed); }
+	long long getCommands() const { return commandsHandled.load(std::memory_order_relaxed); }
+private:
+	Game& game;
+	CommandHandler handleCommand;
+	TickHandler tick;
+	int tickMs;
+	FixedTimestep timestep;
+	SpscQueue<Command> commands;
+	TripleBuffer<Frame> frames;
+	long long published;
+	std::atomic<bool> stopping;
+	std::atomic<bool> running;
+	std::atomic<long long> ticks;
+	std::atomic<long long> commandsHandled;
+	std::thread thread;
+
+	void run();
+	void publish();
+};
@@ -0,0 +1,129 @@
+#include "Snake.h"
+
+namespace {
+
+bool isReversal(char newDirection, char current) {
+	return (newDirection == 'w' && current == 's') || (newDirection == 'a' && current == 'd') || (newDirection == 's' && current == 'w')
+		|| (newDirection == 'd' && current == 'a');
+}
+
+} // namespace
+
+Snake::Snake(int startX, int startY, int columns, int rows, bool indexFreeCells)
+	: segment(static_cast<std::size_t>(columns) * rows), occupancy(columns, rows),
+	freeCells(columns, rows, indexFreeCells && FreeCells::fitsIndex(columns, rows)), startX(startX), startY(startY), points(0),
+	snakeSpeed(startSpeed), r(1.0f), g(1.0f), b(1.0f), direction('d'), appliedInputTime(0), pendingGrowth(0), crashed(false) {
+	segment.push_back({ startX, startY });
+	occupancy.set(startX, startY);
+	freeCells.take(startX, startY);
+	previousTail = segment.back();
+}
+
+void Snake::reset() {
+	// Clear only the cells the body covers, a crashed head sits on a wall bit
+	// and must not be cleared.
+	for (const auto& s : segment) {
+		if (occupancy.isInside(s.x, s.y)) {
+			occupancy.reset(s.x, s.y);
+		}
+	}
+	segment.clear(); // Clear all segments
+	segment.push_back({ startX, startY }); // Reset to initial position
+	occupancy.set(startX, startY);
+	// Rebuilt rather than released cell by cell, so every game starts from
+	// the same free cell order whatever the last one left behind.
+	freeCells.reset();
+	freeCells.take(startX, startY);
+	pendingGrowth = 0;
+	previousTail = segment.back();
+	crashed = false;
+
+	inputs.clear(); // Clear direction queue
+	direction = 'd'; // Reset direction
+	appliedInputTime = 0;
+	snakeSpeed = startSpeed; // Reset speed
+	r = 1.0f;
+	g = 1.0f;
+	b = 1.0f;
+}
+
+void Snake::move() {
+	if (crashed) {
+		return;
+	}
+
+	// One queued turn per move. setDirection() only queues turns that are
+	// valid after the ones ahead of them, check again all the same.
+	appliedInputTime = 0;
+	while (!inputs.empty()) {
+		const InputEvent input = inputs.pop();
+		if (!isReversal(input.direction, direction)) {
+			direction = input.direction;
+			appliedInputTime = input.time;
+			break;
+		}
+	}
+
+	int newX = segment.front().x;
+	int newY = segment.front().y;
+
+	switch (direction) {
+	case 'w':
+		newY += 1;
+		break;
+	case 'a':
+		newX -= 1;
+		break;
+	case 's':
+		newY -= 1;
+		break;
+	case 'd':
+		newX += 1;
+		break;
+	}
+
+	// The tail leaves its cell before the head arrives, so following
+	// the tail around is not a collision.
+	previousTail = segment.back();
+	if (pendingGrowth > 0) {
+		--pendingGrowth;
+	}
+	else {
+		occupancy.reset(previousTail.x, previousTail.y);
+		freeCells.release(previousTail.x, previousTail.y);
+		segment.pop_back();
+	}
+
+	crashed = occupancy.test(newX, newY);
+	segment.push_front({ newX, newY });
+	if (!crashed) {
+		occupancy.set(newX, newY);
+		freeCells.take(newX, newY);
+	}
+}
+
+// The new segment appears at the tail on the next move, so it always lands on
+// a cell the body just left instead of on top of the body or a wall.
+void Snake::grow() {
+	if (segment.size() + pendingGrowth < segment.capacity()) {
+		++pendingGrowth;
+	}
+}
+
+bool Snake::setDirection(char newDirection, std::uint64_t time) {
+	if (newDirection != 'w' && newDirection != 'a' && newDirection != 's' && newDirection != 'd') {
+		return false;
+	}
+	// Relative to where the snake will be heading once the queue is applied.
+	const char heading = inputs.empty() ? direction : inputs.back().direction;
+	if (newDirection == heading || isReversal(newDirection, heading)) {
+		return false;
+	}
+	return inputs.push({ newDirection, time });
+}
+
+void Snake::changeColorToRandom(Random& random) {
+	r = random.nextFloat();
+	g = random.nextFloat();
+	b = random.nextFloat();
+}
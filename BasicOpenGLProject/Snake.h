@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+
+#include "FreeCells.h"
+#include "InputRing.h"
+#include "OccupancyGrid.h"
+#include "Random.h"
+#include "SegmentRing.h"
+
+//=================================================================================================
+// SNAKE
+//=================================================================================================
+
+// Positions are grid cells, (0, 0) is the bottom left cell of the board.
+// Rendering code is responsible for converting cells to pixels.
+//
+// The snake keeps its own occupancy grid in step with the body, so checking
+// whether the head ran into a wall or into itself is a single bit test, and
+// the set of free cells with it, so food never has to look for a place.
+//
+// Turns wait in an InputRing until a move applies them, one per move.
+// setDirection() checks a turn against the last turn queued, or the
+// direction of the last move if none is, so any sequence of keys pressed
+// between two ticks plays out move by move and never reverses the snake
+// into its neck.
+class Snake {
+private:
+	SegmentRing segment;
+	OccupancyGrid occupancy;
+	FreeCells freeCells;
+	InputRing inputs; // turns not applied yet
+	int startX, startY;
+	int points;
+	int snakeSpeed;
+	float r, g, b;
+	char direction; // of the last move
+	std::uint64_t appliedInputTime; // time of the turn the last move applied, 0 if none
+	int pendingGrowth; // segments to add by keeping the tail on upcoming moves
+	SnakeSegment previousTail; // where the tail was before the last move
+	bool crashed;
+
+	friend class Snapshot;
+public:
+	static const int startSpeed = 95;
+
+	// The body can grow until it covers the whole columns x rows board.
+	// Without indexFreeCells the free cells are only counted, for snakes that
+	// share a board and never spawn food from their own set.
+	Snake(int startX, int startY, int columns, int rows, bool indexFreeCells = true);
+	~Snake() {}
+
+	void reset();
+	void move();
+	void grow();
+	// True once the head has moved onto a wall or body cell. A crashed snake
+	// stops moving until reset().
+	bool hasCrashed() const { return crashed; }
+	bool isOccupied(int x, int y) const { return occupancy.test(x, y); }
+	// A uniformly chosen cell the body is not on, false if the body covers
+	// the whole board.
+	bool pickFreeCell(Random& random, int& x, int& y) const {
+		return freeCells.pick(random, [this](int cx, int cy) { return occupancy.test(cx, cy); }, x, y);
+	}
+	// Queues a turn for the coming moves. Returns false, ignoring it, for
+	// anything but 'w', 'a', 's' or 'd', for the direction already headed
+	// in, for a reversal and when the queue is full. time is passed back by
+	// getAppliedInputTime() once a move applies the turn.
+	bool setDirection(char newDirection, std::uint64_t time = 0);
+	void changeColorToRandom(Random& random);
+
+	void addPoints(int amount) { points += amount; }
+	void resetPoints() { points = 0; }
+	void changeSpeed(int delta) { snakeSpeed += delta; }
+
+	int getPoints() const { return points; }
+	int getSpeed() const { return snakeSpeed; }
+	// The direction of the last move, queued turns not included.
+	char getDirection() const { return direction; }
+	// The time passed to setDirection() for the turn the last move applied,
+	// 0 if the move went on in the same direction.
+	std::uint64_t getAppliedInputTime() const { return appliedInputTime; }
+	const InputRing& getInputs() const { return inputs; }
+	int getPendingGrowth() const { return pendingGrowth; }
+
+	float getRed() const { return r; }
+	float getGreen() const { return g; }
+	float getBlue() const { return b; }
+
+	const SnakeSegment& getHead() const { return segment.front(); }
+	const SegmentRing& getBody() const { return segment; }
+	const OccupancyGrid& getOccupancy() const { return occupancy; }
+	const FreeCells& getFreeCells() const { return freeCells; }
+
+	// Where segment i was before the last move: every segment steps into the
+	// cell of the one ahead of it, so that is the cell of segment i + 1, and
+	// for the tail the cell it just left (or its own cell if it grew).
+	const SnakeSegment& getPreviousPosition(std::size_t i) const {
+		return i + 1 < segment.size() ? segment[i + 1] : previousTail;
+	}
+};
@@ -0,0 +1,565 @@
+#include "Snapshot.h"
+#include "Game.h"
+#include "StateHash.h"
+
+#include <climits>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char magic[4] = { 'S', 'N', 'K', 'S' };
+const std::size_t headerSize = sizeof(magic) + 1; // magic and version
+const std::size_t checksumSize = 8;
+
+const std::uint8_t gameOverFlag = 1;
+const std::uint8_t crashedFlag = 2;
+const std::uint8_t freeCellsFlag = 4;
+const std::uint8_t noFood = 0xFF;
+
+// w, a, s, d, and the step each one takes.
+const char directionKeys[4] = { 'w', 'a', 's', 'd' };
+const int stepX[4] = { 0, -1, 0, 1 };
+const int stepY[4] = { 1, 0, -1, 0 };
+
+// Every field but the body steps and the free cells, with varints at their
+// longest.
+const std::size_t fixedSize = 192;
+
+int directionIndex(char direction) {
+	for (int i = 0; i < 4; ++i) {
+		if (directionKeys[i] == direction) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int stepIndex(const SnakeSegment& from, const SnakeSegment& to) {
+	for (int i = 0; i < 4; ++i) {
+		if (to.x == from.x + stepX[i] && to.y == from.y + stepY[i]) {
+			return i;
+		}
+	}
+	return 0; // the body is always connected
+}
+
+// Writes into a buffer already big enough, see Snapshot::maxSize().
+struct Writer {
+	unsigned char* out;
+
+	void fixed(std::uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; ++i) {
+			*out++ = static_cast<unsigned char>(value >> (8 * i));
+		}
+	}
+
+	void varint(std::uint64_t value) {
+		while (value >= 0x80) {
+			*out++ = static_cast<unsigned char>(value | 0x80);
+			value >>= 7;
+		}
+		*out++ = static_cast<unsigned char>(value);
+	}
+
+	void floating(float value) {
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		fixed(bits, 4);
+	}
+};
+
+// Small negative numbers stay short: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+std::uint64_t zigzag(long long value) {
+	return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+long long unzigzag(std::uint64_t value) {
+	return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+// FNV-1a a word at a time with the high bits folded down after every
+// multiply, then the bytes left over: many times quicker than byte by byte
+// and still catches a torn or truncated file.
+std::uint64_t checksum(const unsigned char* data, std::size_t size) {
+	std::uint64_t hash = stateHashSeed;
+	std::size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 1099511628211ULL;
+		hash ^= hash >> 29;
+	}
+	hashBytes(hash, data + i, size - i);
+	return hash;
+}
+
+// Free cells are stored in two bytes each while every cell number fits.
+int cellBytes(int columns, int rows) {
+	return static_cast<std::size_t>(columns) * rows <= 0x10000 ? 2 : 4;
+}
+
+// Reads from a byte range, any read past the end sets ok to false.
+struct Reader {
+	const unsigned char* data;
+	std::size_t size;
+	std::size_t position;
+	bool ok;
+
+	std::uint64_t fixed(int bytes) {
+		if (position + bytes > size) {
+			ok = false;
+			return 0;
+		}
+		std::uint64_t value = 0;
+		for (int i = 0; i < bytes; ++i) {
+			value |= static_cast<std::uint64_t>(data[position++]) << (8 * i);
+		}
+		return value;
+	}
+
+	std::uint64_t varint() {
+		std::uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (position >= size) {
+				break;
+			}
+			const unsigned char byte = data[position++];
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return value;
+			}
+		}
+		ok = false;
+		return 0;
+	}
+
+	float floating() {
+		const std::uint32_t bits = static_cast<std::uint32_t>(fixed(4));
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};
+
+bool isSnapshot(const unsigned char* data, std::size_t size) {
+	if (size < headerSize + checksumSize || std::memcmp(data, magic, sizeof(magic)) != 0 || data[sizeof(magic)] != Snapshot::version) {
+		return false;
+	}
+	Reader in = { data, size, size - checksumSize, true };
+	return in.fixed(checksumSize) == checksum(data, size - checksumSize);
+}
+
+// A whole file mapped into memory, read only or freshly created at a given
+// size for writing.
+class MappedFile {
+private:
+	unsigned char* view;
+	std::size_t length;
+#if defined(_WIN32)
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int file;
+#endif
+public:
+	MappedFile() : view(nullptr), length(0),
+#if defined(_WIN32)
+		file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#else
+		file(-1)
+#endif
+	{}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+#if defined(_WIN32)
+		if (view) {
+			UnmapViewOfFile(view);
+		}
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+#else
+		if (view) {
+			munmap(view, length);
+		}
+		if (file >= 0) {
+			close(file);
+		}
+#endif
+	}
+
+	unsigned char* data() const { return view; }
+	std::size_t size() const { return length; }
+
+	bool openRead(const std::string& path) {
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER fileSize;
+		if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			return false;
+		}
+		length = static_cast<std::size_t>(fileSize.QuadPart);
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		view = mapping ? static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+		file = open(path.c_str(), O_RDONLY);
+		struct stat status;
+		if (file < 0 || fstat(file, &status) != 0 || status.st_size == 0) {
+			return false;
+		}
+		length = static_cast<std::size_t>(status.st_size);
+		void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+		view = mapped == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapped);
+#endif
+		return view != nullptr;
+	}
+
+	bool create(const std::string& path, std::size_t size) {
+		length = size;
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32),
+			static_cast<DWORD>(size), nullptr);
+		view = mapping ? static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size)) : nullptr;
+#else
+		file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (file < 0 || ftruncate(file, static_cast<off_t>(size)) != 0) {
+			return false;
+		}
+		void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		view = mapped == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mapped);
+#endif
+		return view != nullptr;
+	}
+};
+
+} // namespace
+
+std::size_t Snapshot::maxSize(int columns, int rows) {
+	const std::size_t cells = static_cast<std::size_t>(columns) * rows;
+	const std::size_t steps = (cells + 3) / 4;
+	const std::size_t freeCells = FreeCells::fitsIndex(columns, rows) ? cellBytes(columns, rows) * cells : 0;
+	return fixedSize + steps + freeCells + checksumSize;
+}
+
+void Snapshot::capture(const Game& game, Contents contents) {
+	const Snake& snake = game.snake;
+	const SegmentRing& body = snake.segment;
+	const FreeCells& freeCells = snake.freeCells;
+	const bool listFreeCells = contents == Contents::Full && freeCells.isIndexed();
+
+	const std::size_t size = maxSize(game.columns, game.rows);
+	if (bytes.size() < size) {
+		bytes.resize(size);
+	}
+	Writer out = { bytes.data() };
+	for (char c : magic) {
+		out.fixed(static_cast<unsigned char>(c), 1);
+	}
+	out.fixed(version, 1);
+	out.fixed(static_cast<std::uint64_t>(game.columns), 2);
+	out.fixed(static_cast<std::uint64_t>(game.rows), 2);
+	out.fixed(game.seed, 8);
+	out.varint(static_cast<std::uint64_t>(game.ticks));
+	out.fixed((game.gameOver ? gameOverFlag : 0) | (snake.crashed ? crashedFlag : 0) | (listFreeCells ? freeCellsFlag : 0), 1);
+	out.fixed(game.random.getState(), 8);
+	out.fixed(game.random.getIncrement(), 8);
+
+	out.varint(zigzag(snake.points));
+	out.varint(zigzag(snake.snakeSpeed));
+	out.fixed(static_cast<std::uint64_t>(directionIndex(snake.direction)), 1);
+	out.floating(snake.r);
+	out.floating(snake.g);
+	out.floating(snake.b);
+	out.varint(static_cast<std::uint64_t>(snake.pendingGrowth));
+	out.fixed(static_cast<std::uint64_t>(snake.inputs.size()), 1);
+	for (int i = 0; i < snake.inputs.size(); ++i) {
+		out.fixed(static_cast<std::uint64_t>(directionIndex(snake.inputs[i].direction)), 1);
+	}
+
+	out.varint(body.size());
+	out.varint(static_cast<std::uint64_t>(body.front().x + 1));
+	out.varint(static_cast<std::uint64_t>(body.front().y + 1));
+	out.varint(static_cast<std::uint64_t>(snake.previousTail.x + 1));
+	out.varint(static_cast<std::uint64_t>(snake.previousTail.y + 1));
+	unsigned char packed = 0;
+	int bits = 0;
+	for (std::size_t i = 1; i < body.size(); ++i) {
+		packed |= static_cast<unsigned char>(stepIndex(body[i - 1], body[i]) << bits);
+		bits += 2;
+		if (bits == 8) {
+			out.fixed(packed, 1);
+			packed = 0;
+			bits = 0;
+		}
+	}
+	if (bits > 0) {
+		out.fixed(packed, 1);
+	}
+
+	if (game.food) {
+		out.fixed(static_cast<std::uint64_t>(game.food->getKind()), 1);
+		out.varint(static_cast<std::uint64_t>(game.food->getX()));
+		out.varint(static_cast<std::uint64_t>(game.food->getY()));
+	}
+	else {
+		out.fixed(noFood, 1);
+		out.varint(0);
+		out.varint(0);
+	}
+
+	if (listFreeCells) {
+		const std::uint32_t stride = static_cast<std::uint32_t>(game.columns + 2);
+		const int width = cellBytes(game.columns, game.rows);
+		out.varint(freeCells.size());
+		for (std::size_t slot = 0; slot < freeCells.size(); ++slot) {
+			const std::uint32_t cell = freeCells.getFree(slot);
+			const std::uint64_t x = cell % stride - 1;
+			const std::uint64_t y = cell / stride - 1;
+			out.fixed(y * static_cast<std::uint64_t>(game.columns) + x, width);
+		}
+	}
+
+	length = static_cast<std::size_t>(out.out - bytes.data());
+	out.fixed(checksum(bytes.data(), length), checksumSize);
+	length += checksumSize;
+}
+
+bool Snapshot::restore(Game& game) const {
+	if (!isSnapshot(bytes.data(), length)) {
+		return false;
+	}
+	Reader in = { bytes.data(), length - checksumSize, headerSize, true };
+	const int columns = static_cast<int>(in.fixed(2));
+	const int rows = static_cast<int>(in.fixed(2));
+	if (columns != game.columns || rows != game.rows) {
+		return false;
+	}
+
+	// Everything up to the body, checked before the game is touched.
+	const std::uint64_t seed = in.fixed(8);
+	const std::uint64_t ticks = in.varint();
+	const std::uint64_t flags = in.fixed(1);
+	const std::uint64_t randomState = in.fixed(8);
+	const std::uint64_t randomIncrement = in.fixed(8);
+	const long long points = unzigzag(in.varint());
+	const long long speed = unzigzag(in.varint());
+	const std::uint64_t direction = in.fixed(1);
+	const float r = in.floating();
+	const float g = in.floating();
+	const float b = in.floating();
+	const std::uint64_t pendingGrowth = in.varint();
+	const std::uint64_t turnCount = in.fixed(1);
+	char turns[InputRing::capacity];
+	for (std::uint64_t i = 0; i < turnCount && i < InputRing::capacity; ++i) {
+		const std::uint64_t turn = in.fixed(1);
+		turns[i] = turn < 4 ? directionKeys[turn] : 0;
+	}
+	const std::uint64_t length = in.varint();
+	const long long headX = static_cast<long long>(in.varint()) - 1;
+	const long long headY = static_cast<long long>(in.varint()) - 1;
+	const long long tailX = static_cast<long long>(in.varint()) - 1;
+	const long long tailY = static_cast<long long>(in.varint()) - 1;
+	Snake& snake = game.snake;
+	const std::uint64_t capacity = snake.segment.capacity();
+	if (!in.ok || ticks > static_cast<std::uint64_t>(LLONG_MAX) || direction >= 4 || turnCount > InputRing::capacity
+		|| length == 0 || length > capacity || pendingGrowth > capacity - length || headX < -1 || headX > columns || headY < -1
+		|| headY > rows || tailX < -1 || tailX > columns || tailY < -1 || tailY > rows || points < INT_MIN || points > INT_MAX
+		|| speed < INT_MIN || speed > INT_MAX) {
+		return false;
+	}
+	for (std::uint64_t i = 0; i < turnCount; ++i) {
+		if (!turns[i]) {
+			return false;
+		}
+	}
+	const bool crashed = (flags & crashedFlag) != 0;
+	if (((flags & freeCellsFlag) != 0) != snake.freeCells.isIndexed()
+		|| (!crashed && !snake.occupancy.isInside(static_cast<int>(headX), static_cast<int>(headY)))) {
+		return false;
+	}
+
+	// The body goes straight into the snake, a bad cell past this point
+	// starts the game over.
+	const std::uint64_t oldSeed = game.seed;
+	auto fail = [&]() {
+		game.newGame(oldSeed);
+		return false;
+	};
+	snake.reset();
+	snake.occupancy.reset(snake.startX, snake.startY);
+	snake.freeCells.release(snake.startX, snake.startY);
+	snake.segment.clear();
+
+	SnakeSegment segment = { static_cast<int>(headX), static_cast<int>(headY) };
+	unsigned char packed = 0;
+	for (std::uint64_t i = 0; i < length; ++i) {
+		if (i > 0) {
+			if ((i - 1) % 4 == 0) {
+				packed = static_cast<unsigned char>(in.fixed(1));
+			}
+			const int step = (packed >> (2 * ((i - 1) % 4))) & 3;
+			segment.x += stepX[step];
+			segment.y += stepY[step];
+		}
+		snake.segment.push_back(segment);
+		if (i == 0 && crashed) {
+			continue; // on a wall or the body, neither of which it owns
+		}
+		if (!snake.occupancy.isInside(segment.x, segment.y) || snake.occupancy.test(segment.x, segment.y)) {
+			return fail();
+		}
+		snake.occupancy.set(segment.x, segment.y);
+		snake.freeCells.take(segment.x, segment.y);
+	}
+	if (crashed && !snake.occupancy.test(static_cast<int>(headX), static_cast<int>(headY))) {
+		return fail(); // nothing there to crash into
+	}
+
+	const std::uint64_t foodKind = in.fixed(1);
+	const std::uint64_t foodX = in.varint();
+	const std::uint64_t foodY = in.varint();
+	Food* food = nullptr;
+	if (foodKind != noFood) {
+		switch (foodKind) {
+		case static_cast<std::uint64_t>(FoodKind::Apple):
+			food = &game.apple;
+			break;
+		case static_cast<std::uint64_t>(FoodKind::Orange):
+			food = &game.orange;
+			break;
+		case static_cast<std::uint64_t>(FoodKind::Grape):
+			food = &game.grape;
+			break;
+		case static_cast<std::uint64_t>(FoodKind::Banana):
+			food = &game.banana;
+			break;
+		default:
+			return fail();
+		}
+		if (foodX >= static_cast<std::uint64_t>(columns) || foodY >= static_cast<std::uint64_t>(rows)
+			|| snake.occupancy.test(static_cast<int>(foodX), static_cast<int>(foodY))) {
+			return fail();
+		}
+		food->placeAt(static_cast<int>(foodX), static_cast<int>(foodY));
+	}
+
+	if (snake.freeCells.isIndexed()) {
+		const std::uint64_t cells = static_cast<std::uint64_t>(columns) * rows;
+		const int width = cellBytes(columns, rows);
+		if (in.varint() != snake.freeCells.size()) {
+			return fail();
+		}
+		for (std::size_t slot = 0; slot < snake.freeCells.size(); ++slot) {
+			const std::uint64_t cell = in.fixed(width);
+			if (!in.ok || cell >= cells
+				|| !snake.freeCells.placeFree(slot, snake.freeCells.cellIndex(static_cast<int>(cell % columns), static_cast<int>(cell / columns)))) {
+				return fail();
+			}
+		}
+	}
+	if (!in.ok || in.position != in.size) {
+		return fail();
+	}
+
+	game.seed = seed;
+	game.random.setState(randomState, randomIncrement);
+	game.food = food;
+	game.gameOver = (flags & gameOverFlag) != 0;
+	game.ticks = static_cast<long long>(ticks);
+	snake.points = static_cast<int>(points);
+	snake.snakeSpeed = static_cast<int>(speed);
+	snake.direction = directionKeys[direction];
+	snake.r = r;
+	snake.g = g;
+	snake.b = b;
+	snake.pendingGrowth = static_cast<int>(pendingGrowth);
+	snake.previousTail = { static_cast<int>(tailX), static_cast<int>(tailY) };
+	snake.crashed = crashed;
+	for (std::uint64_t i = 0; i < turnCount; ++i) {
+		snake.inputs.push({ turns[i], 0 });
+	}
+	return true;
+}
+
+long long Snapshot::getTicks() const {
+	if (length == 0) {
+		return 0;
+	}
+	Reader in = { bytes.data(), length, headerSize + 2 + 2 + 8, true };
+	return static_cast<long long>(in.varint());
+}
+
+bool Snapshot::save(const std::string& path) const {
+	if (length == 0) {
+		return false;
+	}
+	MappedFile file;
+	if (!file.create(path, length)) {
+		return false;
+	}
+	std::memcpy(file.data(), bytes.data(), length);
+	return true;
+}
+
+bool Snapshot::load(const std::string& path) {
+	MappedFile file;
+	if (!file.openRead(path) || !isSnapshot(file.data(), file.size())) {
+		return false;
+	}
+	bytes.assign(file.data(), file.data() + file.size());
+	length = file.size();
+	return true;
+}
+
+//=================================================================================================
+// SNAPSHOT RING
+//=================================================================================================
+
+SnapshotRing::SnapshotRing(std::size_t capacity, int columns, int rows) : newest(0), count(0) {
+	const std::size_t slotCount = capacity > 0 ? capacity : 1;
+	slots.reserve(slotCount);
+	for (std::size_t i = 0; i < slotCount; ++i) {
+		slots.emplace_back(Snapshot::maxSize(columns, rows));
+	}
+}
+
+void SnapshotRing::push(const Game& game) {
+	newest = count == 0 ? 0 : (newest + 1) % slots.size();
+	slots[newest].capture(game);
+	if (count < slots.size()) {
+		++count;
+	}
+}
+
+const Snapshot& SnapshotRing::get(std::size_t back) const {
+	return slots[(newest + slots.size() - back) % slots.size()];
+}
+
+bool SnapshotRing::rollback(Game& game, std::size_t back) {
+	if (back >= count || !get(back).restore(game)) {
+		return false;
+	}
+	newest = (newest + slots.size() - back) % slots.size();
+	count -= back;
+	return true;
+}
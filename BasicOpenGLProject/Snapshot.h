@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Game;
+
+//=================================================================================================
+// SNAPSHOT
+//=================================================================================================
+
+// Everything a Game needs to carry on exactly as it would have: the body,
+// the queued turns, the food, score, speed, color, tick count and the
+// Random state, plus the order of the free cells, which decides where food
+// spawns next. Restoring a snapshot and playing on with the same keys gives
+// the same game, stateHash() for stateHash().
+//
+// File format, integers little endian, varints as in Replay, svarints
+// zigzag encoded first:
+//   "SNKS" u8 version  u16 columns  u16 rows  u64 seed  varint ticks  u8 flags
+//   u64 randomState  u64 randomIncrement
+//   svarint points  svarint speed  u8 direction  f32 red green blue
+//   varint pendingGrowth  u8 turnCount  u8 turn...
+//   varint length  varint headX + 1  varint headY + 1  varint tailX + 1  varint tailY + 1
+//   2 bits per segment after the head, the step to it from the one before
+//   s8 foodKind (-1 none)  varint foodX  varint foodY
+//   with flag 4: varint freeCount  u16 (y * columns + x) per free cell, in
+//   order, u32 on boards of more than 65536 cells
+//   u64 checksum of everything before it
+// flags: 1 game over, 2 crashed, 4 free cells listed, which only boards
+// with a free cell index (see FreeCells) have.
+// tail is where the tail was before the last move. A default board snapshot
+// is about 1 KB, mostly the free cell order.
+//
+// Capturing into a snapshot whose buffer already holds maxSize() bytes never
+// allocates, so a SnapshotRing can keep one per tick.
+//
+// A Display snapshot leaves the free cell order out, all a game that is only
+// drawn needs. It restores only into a game without a free cell index, so
+// capturing and restoring it cost the length of the snake, not the size of
+// the board.
+class Snapshot {
+public:
+	static const std::uint8_t version = 1;
+
+	enum class Contents { Full, Display };
+
+	explicit Snapshot(std::size_t reserveBytes = 0) : bytes(reserveBytes), length(0) {}
+
+	// Largest snapshot of a columns x rows board.
+	static std::size_t maxSize(int columns, int rows);
+
+	void capture(const Game& game, Contents contents = Contents::Full);
+	// Puts game back in the captured state. False if the snapshot is of a
+	// board of another size or does not hold a valid state; a game whose
+	// restore failed part way is started over from its seed.
+	bool restore(Game& game) const;
+
+	// Through a memory mapping of the file. load() fails on anything that is
+	// not a snapshot of this version with a matching checksum.
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+	bool empty() const { return length == 0; }
+	std::size_t size() const { return length; }
+	const unsigned char* data() const { return bytes.data(); }
+	// Tick the game was on when captured, 0 if empty.
+	long long getTicks() const;
+private:
+	std::vector<unsigned char> bytes; // the snapshot, then room to capture a larger one
+	std::size_t length;
+};
+
+//=================================================================================================
+// SNAPSHOT RING
+//=================================================================================================
+
+// The last capacity() states of a game, one push() per tick, for rewinding
+// it. Every slot is sized for the board up front, so pushing never
+// allocates.
+class SnapshotRing {
+private:
+	std::vector<Snapshot> slots;
+	std::size_t newest;
+	std::size_t count;
+public:
+	SnapshotRing(std::size_t capacity, int columns, int rows);
+
+	std::size_t capacity() const { return slots.size(); }
+	std::size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	void clear() { count = 0; }
+
+	// Captures game over the oldest state when the ring is full.
+	void push(const Game& game);
+	// State back pushes before the newest, 0 is the newest.
+	const Snapshot& get(std::size_t back) const;
+	// Restores the state back pushes before the newest and forgets the ones
+	// after it. False, leaving game alone, if the ring does not go back that
+	// far.
+	bool rollback(Game& game, std::size_t back);
+};
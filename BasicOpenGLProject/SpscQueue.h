@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//=================================================================================================
+// SPSC QUEUE
+//=================================================================================================
+
+// Fixed size FIFO from exactly one producer thread to exactly one consumer
+// thread, lock free: each side only writes its own index, and the release
+// store of an index publishes the slot behind it. Like InputRing, a push
+// onto a full queue fails and is counted rather than waiting or allocating.
+template <class T>
+class SpscQueue {
+private:
+	std::vector<T> slots;
+	std::size_t mask;
+	alignas(64) std::atomic<std::size_t> head; // next to pop, written by the consumer
+	alignas(64) std::atomic<std::size_t> tail; // next to push, written by the producer
+	std::size_t dropped;                       // the producer's
+
+	static std::size_t roundUp(std::size_t n) {
+		std::size_t power = 1;
+		while (power < n) {
+			power *= 2;
+		}
+		return power;
+	}
+public:
+	// Holds at least capacity items, rounded up to a power of two.
+	explicit SpscQueue(std::size_t capacity) : slots(roundUp(capacity)), mask(slots.size() - 1), head(0), tail(0), dropped(0) {}
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	std::size_t capacity() const { return slots.size(); }
+
+	// Producer thread.
+	bool push(const T& value) {
+		const std::size_t position = tail.load(std::memory_order_relaxed);
+		if (position - head.load(std::memory_order_acquire) == slots.size()) {
+			++dropped;
+			return false;
+		}
+		slots[position & mask] = value;
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+	// Items turned away by push(), producer thread only.
+	std::size_t getDropped() const { return dropped; }
+
+	// Consumer thread.
+	bool pop(T& value) {
+		const std::size_t position = head.load(std::memory_order_relaxed);
+		if (position == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = slots[position & mask];
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+};
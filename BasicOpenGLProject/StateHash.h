@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a, shared by Game::stateHash() and BatchEngine::stateHash() so the two
+// hash the same state to the same value.
+const std::uint64_t stateHashSeed = 14695981039346656037ULL;
+
+inline void hashBytes(std::uint64_t& hash, const void* data, std::size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+}
+
+template <typename T>
+void hashValue(std::uint64_t& hash, const T& value) {
+	hashBytes(hash, &value, sizeof(value));
+}
@@ -0,0 +1,231 @@
+#include "TextRenderer.h"
+
+namespace {
+
+// Empty texels left and right of every glyph, for fonts whose glyphs reach
+// outside their advance.
+const int padding = 2;
+const int maxAtlasWidth = 512;
+// Vertices draw() holds without allocating, a screenful of short labels.
+const std::size_t stagingVertices = 2048;
+
+int nextPowerOfTwo(int n) {
+	int power = 1;
+	while (power < n) {
+		power *= 2;
+	}
+	return power;
+}
+
+} // namespace
+
+TextRenderer::TextRenderer()
+	: font(), texture(0), atlasWidth(0), atlasHeight(0), cellHeight(0), baseline(0), atlasEnabled(true), glyphs(), drawCalls(0) {}
+
+bool TextRenderer::init(GLProcLoader loader, const BitmapFont& newFont) {
+	release();
+	gl.load(loader);
+	font = newFont;
+	staging.reserve(stagingVertices);
+	for (int c = firstCharacter; c <= lastCharacter; ++c) {
+		glyphs[c - firstCharacter].width = font.characterWidth(font.font, c);
+	}
+	return buildAtlas();
+}
+
+void TextRenderer::release() {
+	if (texture) {
+		glDeleteTextures(1, &texture);
+		texture = 0;
+	}
+}
+
+// Draws every glyph into a framebuffer object the size of the atlas, with
+// the baseline in the middle of a cell twice the font's height so neither
+// descenders nor tall glyphs are cut off, and reads the pixels back as the
+// alpha of the atlas texture.
+bool TextRenderer::buildAtlas() {
+	if (!gl.hasFramebuffers()) {
+		return false;
+	}
+
+	cellHeight = 2 * font.height;
+	baseline = font.height;
+	int x = 0;
+	int y = 0;
+	for (Glyph& glyph : glyphs) {
+		const int cellWidth = glyph.width + 2 * padding;
+		if (cellWidth > maxAtlasWidth) {
+			return false;
+		}
+		if (x + cellWidth > maxAtlasWidth) {
+			x = 0;
+			y += cellHeight;
+		}
+		glyph.left = x + padding;
+		glyph.bottom = y;
+		x += cellWidth;
+	}
+	atlasWidth = maxAtlasWidth;
+	atlasHeight = nextPowerOfTwo(y + cellHeight);
+
+	GLint previousFramebuffer = 0;
+	GLint viewport[4];
+	GLfloat clearColor[4];
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+	GLuint colorBuffer = 0;
+	GLuint framebuffer = 0;
+	gl.GenRenderbuffers(1, &colorBuffer);
+	gl.BindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	gl.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, atlasWidth, atlasHeight);
+	gl.GenFramebuffers(1, &framebuffer);
+	gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	const bool complete = gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	std::vector<unsigned char> alpha(static_cast<std::size_t>(atlasWidth) * atlasHeight);
+	if (complete) {
+		glViewport(0, 0, atlasWidth, atlasHeight);
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glLoadIdentity();
+		glOrtho(0, atlasWidth, 0, atlasHeight, -1, 1);
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+		glLoadIdentity();
+
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glColor3f(1.0f, 1.0f, 1.0f);
+		for (int c = firstCharacter; c <= lastCharacter; ++c) {
+			const Glyph& glyph = glyphs[c - firstCharacter];
+			glRasterPos2i(glyph.left, glyph.bottom + baseline);
+			font.drawCharacter(font.font, c);
+		}
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, atlasWidth, atlasHeight, GL_RED, GL_UNSIGNED_BYTE, alpha.data());
+
+		glPopMatrix();
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+	}
+
+	gl.BindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+	gl.DeleteFramebuffers(1, &framebuffer);
+	gl.DeleteRenderbuffers(1, &colorBuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+	if (!complete) {
+		return false;
+	}
+
+	GLint unpackAlignment = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, atlasWidth, atlasHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, alpha.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+	return true;
+}
+
+int TextRenderer::measure(const char* text) const {
+	int width = 0;
+	for (const char* c = text; *c; ++c) {
+		if (*c >= firstCharacter && *c <= lastCharacter) {
+			width += glyphs[*c - firstCharacter].width;
+		}
+	}
+	return width;
+}
+
+void TextRenderer::layout(Label& label, const char* text, int x, int y, float r, float g, float b) const {
+	label.text.assign(text);
+	label.x = x;
+	label.y = y;
+	label.r = r;
+	label.g = g;
+	label.b = b;
+	label.vertices.clear();
+
+	int pen = x;
+	for (const char* c = text; *c; ++c) {
+		if (*c < firstCharacter || *c > lastCharacter) {
+			continue;
+		}
+		const Glyph& glyph = glyphs[*c - firstCharacter];
+		if (hasAtlas() && *c != ' ') {
+			// The whole cell, padding included, texel for pixel.
+			const float left = static_cast<float>(pen - padding);
+			const float right = static_cast<float>(pen + glyph.width + padding);
+			const float bottom = static_cast<float>(y - baseline);
+			const float top = bottom + cellHeight;
+			const float u0 = static_cast<float>(glyph.left - padding) / atlasWidth;
+			const float u1 = static_cast<float>(glyph.left + glyph.width + padding) / atlasWidth;
+			const float v0 = static_cast<float>(glyph.bottom) / atlasHeight;
+			const float v1 = static_cast<float>(glyph.bottom + cellHeight) / atlasHeight;
+			label.vertices.push_back({ left, bottom, u0, v0, r, g, b });
+			label.vertices.push_back({ right, bottom, u1, v0, r, g, b });
+			label.vertices.push_back({ right, top, u1, v1, r, g, b });
+			label.vertices.push_back({ left, top, u0, v1, r, g, b });
+		}
+		pen += glyph.width;
+	}
+	label.width = pen - x;
+}
+
+void TextRenderer::draw(const Label* const* labels, std::size_t count) {
+	drawCalls = 0;
+	if (!isAtlasEnabled()) {
+		for (std::size_t i = 0; i < count; ++i) {
+			drawCharacters(*labels[i]);
+		}
+		return;
+	}
+
+	staging.clear();
+	for (std::size_t i = 0; i < count; ++i) {
+		staging.insert(staging.end(), labels[i]->vertices.begin(), labels[i]->vertices.end());
+	}
+	if (staging.empty()) {
+		return;
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &staging[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &staging[0].u);
+	glColorPointer(3, GL_FLOAT, sizeof(Vertex), &staging[0].r);
+	glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(staging.size()));
+	++drawCalls;
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisable(GL_BLEND);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
+// The path without an atlas: the raster position picks up the color, the
+// font advances it.
+void TextRenderer::drawCharacters(const Label& label) {
+	glColor3f(label.r, label.g, label.b);
+	glRasterPos2i(label.x, label.y);
+	for (char c : label.text) {
+		font.drawCharacter(font.font, c);
+		++drawCalls;
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "GLExtensions.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A bitmap font drawn with glBitmap at the current raster position, which
+// it then advances, as glutBitmapCharacter(), glutBitmapWidth() and
+// glutBitmapHeight() do. font is passed back to both calls.
+struct BitmapFont {
+	void (*drawCharacter)(void* font, int character);
+	int (*characterWidth)(void* font, int character);
+	void* font;
+	int height; // line height in pixels
+};
+
+//=================================================================================================
+// TEXT RENDERER
+//=================================================================================================
+
+// Draws text in a BitmapFont without going through the font per character
+// on every frame. Like Renderer it knows nothing about GLUT.
+//
+// init() draws every printable character once into a framebuffer object
+// and keeps the result as an alpha texture, the glyph atlas. A Label is a
+// string laid out once into textured quads; draw() sends any number of
+// labels in a single draw call, and only labels whose text changed need
+// laying out again. The atlas holds the font's own pixels and each quad
+// covers whole pixels, so atlas text is pixel for pixel what the font draws.
+//
+// Without framebuffer objects, or with the atlas turned off, labels are
+// drawn through the font one character at a time as before.
+class TextRenderer {
+public:
+	struct Vertex {
+		float x, y;
+		float u, v;
+		float r, g, b;
+	};
+
+	// Text laid out at a position and color. Keeps its storage between
+	// layouts, so laying out text no longer than before never allocates.
+	class Label {
+	private:
+		friend class TextRenderer;
+		std::string text;
+		int x, y;
+		int width;
+		float r, g, b;
+		std::vector<Vertex> vertices; // four per visible character
+	public:
+		explicit Label(std::size_t reserveCharacters = 32) : x(0), y(0), width(0), r(1.0f), g(1.0f), b(1.0f) {
+			text.reserve(reserveCharacters);
+			vertices.reserve(reserveCharacters * 4);
+		}
+
+		const std::string& getText() const { return text; }
+		int getWidth() const { return width; }
+	};
+
+	TextRenderer();
+	TextRenderer(const TextRenderer&) = delete;
+	TextRenderer& operator=(const TextRenderer&) = delete;
+
+	// Builds the atlas for font; a context must be current. Returns false,
+	// and draws through the font, if framebuffer objects are unavailable.
+	bool init(GLProcLoader loader, const BitmapFont& font);
+	// Frees the atlas, call while the context is still current.
+	void release();
+
+	bool hasAtlas() const { return texture != 0; }
+	void setAtlasEnabled(bool enabled) { atlasEnabled = enabled; }
+	bool isAtlasEnabled() const { return atlasEnabled && hasAtlas(); }
+
+	int getHeight() const { return font.height; }
+	// Width of text in pixels.
+	int measure(const char* text) const;
+
+	// Lays text out with the left end of its baseline at x, y in window
+	// pixels.
+	void layout(Label& label, const char* text, int x, int y, float r, float g, float b) const;
+
+	// Draws every label in one draw call with the atlas, or one per
+	// character without it.
+	void draw(const Label* const* labels, std::size_t count);
+	void draw(const Label& label) {
+		const Label* one = &label;
+		draw(&one, 1);
+	}
+
+	// Draw calls issued by the last draw().
+	int getDrawCalls() const { return drawCalls; }
+private:
+	static const int firstCharacter = 32;
+	static const int lastCharacter = 126;
+
+	// Where a character is in the atlas, in texels. The cell's baseline is
+	// baseline texels above its bottom.
+	struct Glyph {
+		int left, bottom;
+		int width; // advance, as the font reports it
+	};
+
+	GLExtensions gl;
+	BitmapFont font;
+	GLuint texture;
+	int atlasWidth, atlasHeight;
+	int cellHeight, baseline;
+	bool atlasEnabled;
+	Glyph glyphs[lastCharacter - firstCharacter + 1];
+	std::vector<Vertex> staging; // every label of one draw()
+	int drawCalls;
+
+	bool buildAtlas();
+	void drawCharacters(const Label& label);
+};
@@ -0,0 +1,132 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads) : task(nullptr), generation(0), busy(0), stopping(false) {
+	if (threads <= 0) {
+		threads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	if (threads <= 0) {
+		threads = 1;
+	}
+
+	slices.reset(new Slice[threads]);
+	workers.reserve(threads);
+	for (int i = 0; i < threads; ++i) {
+		workers.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::parallelFor(std::size_t count, const Task& newTask) {
+	if (count == 0) {
+		return;
+	}
+
+	const std::size_t threads = workers.size();
+	for (std::size_t i = 0; i < threads; ++i) {
+		std::lock_guard<std::mutex> lock(slices[i].mutex);
+		slices[i].begin = count * i / threads;
+		slices[i].end = count * (i + 1) / threads;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	task = &newTask;
+	busy = static_cast<int>(threads);
+	++generation;
+	wake.notify_all();
+	finished.wait(lock, [this] { return busy == 0; });
+	task = nullptr;
+}
+
+void ThreadPool::workerLoop(int worker) {
+	unsigned long long seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+		}
+
+		runSlices(worker);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busy == 0) {
+			finished.notify_all();
+		}
+	}
+}
+
+void ThreadPool::runSlices(int worker) {
+	std::size_t index;
+	for (;;) {
+		while (takeOwn(worker, index)) {
+			(*task)(index, worker);
+		}
+		if (!steal(worker)) {
+			return;
+		}
+	}
+}
+
+bool ThreadPool::takeOwn(int worker, std::size_t& index) {
+	Slice& own = slices[worker];
+	std::lock_guard<std::mutex> lock(own.mutex);
+	if (own.begin == own.end) {
+		return false;
+	}
+	index = own.begin++;
+	return true;
+}
+
+// Moves the back half of the fullest other slice into this worker's slice.
+// Returns false when every slice is empty.
+bool ThreadPool::steal(int worker) {
+	const int threads = getThreadCount();
+	for (;;) {
+		int victim = -1;
+		std::size_t most = 0;
+		for (int i = 0; i < threads; ++i) {
+			if (i == worker) {
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(slices[i].mutex);
+			const std::size_t left = slices[i].end - slices[i].begin;
+			if (left > most) {
+				most = left;
+				victim = i;
+			}
+		}
+		if (victim < 0) {
+			return false;
+		}
+
+		std::size_t begin, end;
+		{
+			std::lock_guard<std::mutex> lock(slices[victim].mutex);
+			const std::size_t left = slices[victim].end - slices[victim].begin;
+			if (left == 0) {
+				continue; // emptied since we looked, pick again
+			}
+			end = slices[victim].end;
+			begin = end - (left + 1) / 2;
+			slices[victim].end = begin;
+		}
+
+		std::lock_guard<std::mutex> lock(slices[worker].mutex);
+		slices[worker].begin = begin;
+		slices[worker].end = end;
+		return true;
+	}
+}
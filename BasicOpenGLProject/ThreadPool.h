@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//=================================================================================================
+// THREAD POOL
+//=================================================================================================
+
+// Fixed set of worker threads running parallel loops with work stealing.
+// parallelFor() hands every worker an equal slice of the index range; a worker
+// takes indices from the front of its own slice, and when that runs dry it
+// steals the back half of the largest slice left, so workers that drew cheap
+// items (short games) keep busy until the whole range is done.
+class ThreadPool {
+public:
+	typedef std::function<void(std::size_t index, int worker)> Task;
+
+	// threads <= 0 uses one thread per hardware core.
+	explicit ThreadPool(int threads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+	// Calls task(i, worker) once for every i in [0, count) and returns when
+	// all calls have finished. worker is in [0, getThreadCount()) and no two
+	// calls with the same worker run at the same time, so it can index
+	// per-thread scratch state.
+	void parallelFor(std::size_t count, const Task& task);
+private:
+	// One per worker, padded so neighbouring workers don't share a cache line.
+	struct alignas(64) Slice {
+		std::mutex mutex;
+		std::size_t begin = 0;
+		std::size_t end = 0;
+	};
+
+	std::vector<std::thread> workers;
+	std::unique_ptr<Slice[]> slices;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	const Task* task;
+	unsigned long long generation;
+	int busy;
+	bool stopping;
+
+	void workerLoop(int worker);
+	void runSlices(int worker);
+	bool takeOwn(int worker, std::size_t& index);
+	bool steal(int worker);
+};
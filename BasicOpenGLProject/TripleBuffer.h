@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+
+//=================================================================================================
+// TRIPLE BUFFER
+//=================================================================================================
+
+// Hands the newest of a stream of values from one writer thread to one
+// reader thread without locks and without either side ever waiting. The
+// writer fills the back slot and publish() swaps it with the middle one; the
+// reader's acquire() swaps the middle slot with its front one if something
+// was published since, so each side always owns a slot the other cannot
+// touch. The reader skips values published faster than it reads, the writer
+// never waits for a slow reader.
+template <class T>
+class TripleBuffer {
+private:
+	static const unsigned indexMask = 3;
+	static const unsigned freshBit = 4; // set in middle by publish(), cleared by acquire()
+
+	T slots[3];
+	unsigned back;  // the writer's
+	alignas(64) std::atomic<unsigned> middle;
+	alignas(64) unsigned front; // the reader's
+public:
+	// Every slot starts as a copy of initial, so slots that own storage
+	// (a Snapshot sized for the board) are all sized up front.
+	explicit TripleBuffer(const T& initial = T()) : slots{ initial, initial, initial }, back(0), middle(1), front(2) {}
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer thread.
+	T& getBack() { return slots[back]; }
+	void publish() {
+		back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// Reader thread. True if a newer value than getFront() was published,
+	// which getFront() is then.
+	bool acquire() {
+		if ((middle.load(std::memory_order_relaxed) & freshBit) == 0) {
+			return false;
+		}
+		front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+	const T& getFront() const { return slots[front]; }
+};
@@ -0,0 +1,607 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "Bot.h"
+#include "FoodRules.h"
+#include "Game.h"
+#include "Snapshot.h"
+
+#if defined(SNAKE_BENCH_OFFSCREEN)
+#include "FrameCapture.h"
+#include "OffscreenContext.h"
+#include "Renderer.h"
+#endif
+
+//=================================================================================================
+// MICROBENCHMARKS
+//=================================================================================================
+
+// Times the pieces of a tick, and with an offscreen context a rendered frame,
+// at snake lengths from 1 up to the whole default board, and prints the
+// results as JSON, one result per line:
+//
+//   snake_bench [--out FILE] [--baseline FILE] [--tolerance PERCENT] [--min-time MS]
+//
+// Every result is the best of several timed runs, in nanoseconds per call.
+// --baseline compares against the output of an earlier build and fails if
+// any result got slower by more than --tolerance percent (default 10).
+//
+// The separate wall and self collision checks are gone: the snake's
+// occupancy grid has a wall border, so "collision" times Snake::isOccupied()
+// on cells all over and around the board, and Game::checkCollision() only
+// reads the flag Snake::move() sets.
+//
+// The "_static" results time the default board and food rules fixed at
+// compile time (StaticBoard, StaticOccupancy and applyFood below) next to
+// the runtime code they would specialize:
+// "food_effect_virtual" calls through the GameObject vtable, "food_effect"
+// through Food as the game does, and "cell_decode" turns padded cell indices
+// back into x and y as FreeCells::pick() does.
+//
+// "capture_ppm" and "capture_y4m" stream a rendered frame out as video.
+
+namespace {
+
+// DefaultBoard with its cells numbered at compile time: like OccupancyGrid,
+// with a one cell border, but rows padded to a power of two so a cell index
+// decodes to x and y with a mask and a shift.
+template <class BoardT>
+struct StaticBoard {
+	static constexpr int log2Ceil(int n) {
+		int shift = 0;
+		while ((1 << shift) < n) {
+			++shift;
+		}
+		return shift;
+	}
+
+	static constexpr int columns = BoardT::columns;
+	static constexpr int rows = BoardT::rows;
+	static constexpr std::size_t cells = static_cast<std::size_t>(columns) * rows;
+	static constexpr int strideShift = log2Ceil(columns + 2);
+	static constexpr int stride = 1 << strideShift;
+	static constexpr std::size_t paddedCells = static_cast<std::size_t>(stride) * (rows + 2);
+
+	// x and y may be anywhere from -1 to columns/rows.
+	static constexpr std::size_t index(int x, int y) {
+		return (static_cast<std::size_t>(y + 1) << strideShift) + static_cast<std::size_t>(x + 1);
+	}
+	static constexpr int column(std::size_t index) { return static_cast<int>(index & (stride - 1)) - 1; }
+	static constexpr int row(std::size_t index) { return static_cast<int>(index >> strideShift) - 1; }
+};
+
+// OccupancyGrid for a StaticBoard: one bit per cell, border bits always
+// set, in a fixed array with no paged mode to branch on.
+template <class StaticBoardT>
+class StaticOccupancy {
+private:
+	static constexpr std::size_t wordCount = (StaticBoardT::paddedCells + 63) / 64;
+	std::array<std::uint64_t, wordCount> bits;
+
+	void setIndex(std::size_t i) { bits[i >> 6] |= std::uint64_t(1) << (i & 63); }
+public:
+	StaticOccupancy() {
+		bits.fill(0);
+		for (int x = -1; x <= StaticBoardT::columns; ++x) {
+			setIndex(StaticBoardT::index(x, -1));
+			setIndex(StaticBoardT::index(x, StaticBoardT::rows));
+		}
+		for (int y = 0; y < StaticBoardT::rows; ++y) {
+			setIndex(StaticBoardT::index(-1, y));
+			setIndex(StaticBoardT::index(StaticBoardT::columns, y));
+		}
+	}
+
+	bool test(int x, int y) const {
+		const std::size_t i = StaticBoardT::index(x, y);
+		return (bits[i >> 6] >> (i & 63)) & 1u;
+	}
+	void set(int x, int y) { setIndex(StaticBoardT::index(x, y)); }
+};
+
+using DefaultStaticBoard = StaticBoard<DefaultBoard>;
+
+// A food rule with the kind known at compile time, every branch folds away.
+template <FoodKind Kind, class SnakeT, class RandomT>
+void applyFood(SnakeT& snake, RandomT& random) {
+	constexpr FoodRule rule = foodRule(Kind);
+	applyFoodRule(rule, snake, random);
+}
+
+struct Options {
+	std::string outPath;
+	std::string baselinePath;
+	double tolerance = 10.0;
+	double minTime = 20.0; // milliseconds per timed run
+};
+
+struct Result {
+	std::string name;
+	int length;
+	double nsPerOp;
+};
+
+// Calls op(count) with growing counts until one run takes minTime, then
+// returns the best time per call of a few runs of that size. prepare(), if
+// any work has to be redone between runs, is not timed. Ops that can only
+// run maxCount times in a row get many more, shorter runs.
+template <typename Prepare, typename Op>
+double measure(const Options& options, Prepare prepare, Op op, long long maxCount = 1LL << 40) {
+	using Clock = std::chrono::steady_clock;
+	long long count = 1;
+	for (;;) {
+		prepare();
+		const auto start = Clock::now();
+		op(count);
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		if (ms >= options.minTime || count >= maxCount) {
+			break;
+		}
+		count = ms > 0.5 ? static_cast<long long>(count * options.minTime / ms) + 1 : count * 8;
+	}
+	const int runs = count >= maxCount ? 100 : 5;
+	count = std::min(count, maxCount);
+
+	double best = 0.0;
+	for (int run = 0; run < runs; ++run) {
+		prepare();
+		const auto start = Clock::now();
+		op(count);
+		const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+		best = run == 0 || ns < best ? ns : best;
+	}
+	return best;
+}
+
+// See cycleDirection() in Bot.h, the start cell (13, 10) heading right is on
+// the default board's cycle.
+void followCycle(Snake& snake, int columns, int rows) {
+	const SnakeSegment& head = snake.getHead();
+	snake.setDirection(cycleDirection(head.x, head.y, columns, rows));
+}
+
+// A fresh game whose snake has grown to length cells along the cycle.
+void buildSnake(Game& game, int length, std::uint64_t seed = 1) {
+	game.newGame(seed);
+	Snake& snake = game.getSnake();
+	for (int i = 1; i < length; ++i) {
+		snake.grow();
+		followCycle(snake, game.getColumns(), game.getRows());
+		snake.move();
+	}
+}
+
+// A fresh game played along the cycle until its snake has eaten its way to
+// length cells, or filled the board.
+void playToLength(Game& game, int length, std::uint64_t seed = 1) {
+	game.newGame(seed);
+	while (static_cast<int>(game.getSnake().getBody().size()) < length && game.getFood() && !game.isGameOver()) {
+		followCycle(game.getSnake(), game.getColumns(), game.getRows());
+		game.update();
+	}
+}
+
+// How many ticks the snake can follow the cycle before it eats.
+int ticksUntilMeal(const Game& game) {
+	int x = game.getSnake().getHead().x;
+	int y = game.getSnake().getHead().y;
+	const int cells = game.getColumns() * game.getRows();
+	for (int ticks = 1; ticks <= cells; ++ticks) {
+		switch (cycleDirection(x, y, game.getColumns(), game.getRows())) {
+		case 'w': y += 1; break;
+		case 'a': x -= 1; break;
+		case 's': y -= 1; break;
+		case 'd': x += 1; break;
+		}
+		if (x == game.getFood()->getX() && y == game.getFood()->getY()) {
+			return ticks;
+		}
+	}
+	return cells;
+}
+
+// Keeps results alive so the compiler cannot drop the work.
+volatile long long sink;
+
+bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+			options.outPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue) {
+			options.baselinePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+			options.tolerance = std::atof(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+			options.minTime = std::atof(argv[++i]);
+		}
+		else {
+			std::cerr << "usage: " << argv[0] << " [--out FILE] [--baseline FILE] [--tolerance PERCENT] [--min-time MS]\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+void benchSimulation(const Options& options, const std::vector<int>& lengths, std::vector<Result>& results) {
+	Game game;
+	const int columns = game.getColumns();
+	const int rows = game.getRows();
+	Random random(1);
+	Apple apple;
+
+	for (int length : lengths) {
+		buildSnake(game, length);
+		Snake& snake = game.getSnake();
+
+		results.push_back({ "move", length, measure(options, [] {}, [&](long long count) {
+			for (long long i = 0; i < count; ++i) {
+				followCycle(snake, columns, rows);
+				snake.move();
+			}
+			sink = snake.getHead().x;
+		}) });
+
+		results.push_back({ "collision", length, measure(options, [] {}, [&](long long count) {
+			long long hits = 0;
+			int x = -1;
+			int y = -1;
+			for (long long i = 0; i < count; ++i) {
+				hits += snake.isOccupied(x, y);
+				if (++x > columns) {
+					x = -1;
+					y = y == rows ? -1 : y + 1;
+				}
+			}
+			sink = hits;
+		}) });
+
+		StaticOccupancy<DefaultStaticBoard> board;
+		for (const SnakeSegment& segment : snake.getBody()) {
+			board.set(segment.x, segment.y);
+		}
+		results.push_back({ "collision_static", length, measure(options, [] {}, [&](long long count) {
+			long long hits = 0;
+			int x = -1;
+			int y = -1;
+			for (long long i = 0; i < count; ++i) {
+				hits += board.test(x, y);
+				if (++x > columns) {
+					x = -1;
+					y = y == rows ? -1 : y + 1;
+				}
+			}
+			sink = hits;
+		}) });
+
+		results.push_back({ "check_collision", length, measure(options, [] {}, [&](long long count) {
+			for (long long i = 0; i < count; ++i) {
+				game.checkCollision();
+			}
+			sink = game.isGameOver();
+		}) });
+
+		// One pick from the free cell index, whatever the length. On the full
+		// board it only finds there is no free cell.
+		results.push_back({ "place_random", length, measure(options, [] {}, [&](long long count) {
+			for (long long i = 0; i < count; ++i) {
+				apple.placeRandom(snake, random);
+			}
+			sink = apple.getX();
+		}) });
+
+		// Save-state and rollback cost, see SnapshotRing. buildSnake() can
+		// leave the food under the body, which no snapshot restores, so these
+		// use a game that grew by eating.
+		Game played(columns, rows);
+		playToLength(played, length);
+		Snapshot snapshot(Snapshot::maxSize(columns, rows));
+		results.push_back({ "snapshot_capture", length, measure(options, [] {}, [&](long long count) {
+			for (long long i = 0; i < count; ++i) {
+				snapshot.capture(played);
+			}
+			sink = static_cast<long long>(snapshot.size());
+		}) });
+		Game restored(columns, rows);
+		results.push_back({ "snapshot_restore", length, measure(options, [] {}, [&](long long count) {
+			long long restores = 0;
+			for (long long i = 0; i < count; ++i) {
+				restores += snapshot.restore(restored);
+			}
+			sink = restores;
+		}) });
+		if (!snapshot.restore(restored) || restored.stateHash() != played.stateHash()) {
+			std::cerr << "error: a snapshot of a snake of length " << length << " does not restore\n";
+		}
+
+		// A meal would change the length, or end the game on a full board.
+		// Pick a game whose food is far enough ahead and rebuild it for every
+		// short run.
+		const int updateTicks = 256;
+		std::uint64_t seed = 1;
+		buildSnake(game, length, seed);
+		while (ticksUntilMeal(game) <= updateTicks) {
+			buildSnake(game, length, ++seed);
+		}
+		results.push_back({ "update", length, measure(options, [&] { buildSnake(game, length, seed); }, [&](long long count) {
+			for (long long i = 0; i < count; ++i) {
+				followCycle(snake, columns, rows);
+				game.update();
+			}
+			sink = game.getTicks();
+		}, updateTicks) });
+	}
+
+	// grow() only books the growth, the growing move pays for it.
+	const int cells = columns * rows;
+	Snake& snake = game.getSnake();
+	results.push_back({ "grow_and_move", 0, measure(options, [&] { buildSnake(game, 1); }, [&](long long count) {
+		for (long long i = 0; i < count; ++i) {
+			if (snake.getBody().size() + snake.getPendingGrowth() >= static_cast<std::size_t>(cells)) {
+				buildSnake(game, 1);
+			}
+			snake.grow();
+			followCycle(snake, columns, rows);
+			snake.move();
+		}
+		sink = static_cast<long long>(snake.getBody().size());
+	}) });
+}
+
+// Food effects cycling through the four kinds, and cell index decoding.
+void benchRules(const Options& options, std::vector<Result>& results) {
+	static_assert(Game::defaultColumns == DefaultBoard::columns && Game::defaultRows == DefaultBoard::rows,
+		"the static results run on the default board");
+	Game game;
+	Snake& snake = game.getSnake();
+	Random random(1);
+	Apple apple;
+	Orange orange;
+	Grape grape;
+	Banana banana;
+	const Food* foods[4] = { &apple, &orange, &grape, &banana };
+	const GameObject* objects[4] = { &apple, &orange, &grape, &banana };
+	auto resetSnake = [&] {
+		snake.reset();
+		snake.resetPoints();
+	};
+
+	results.push_back({ "food_effect_virtual", 0, measure(options, resetSnake, [&](long long count) {
+		for (long long i = 0; i < count; ++i) {
+			objects[i & 3]->foodEffect(snake, random);
+		}
+		sink = snake.getPoints();
+	}) });
+
+	results.push_back({ "food_effect", 0, measure(options, resetSnake, [&](long long count) {
+		for (long long i = 0; i < count; ++i) {
+			foods[i & 3]->foodEffect(snake, random);
+		}
+		sink = snake.getPoints();
+	}) });
+
+	results.push_back({ "food_effect_static", 0, measure(options, resetSnake, [&](long long count) {
+		for (long long i = 0; i < count; ++i) {
+			switch (i & 3) {
+			case 0: applyFood<FoodKind::Apple>(snake, random); break;
+			case 1: applyFood<FoodKind::Orange>(snake, random); break;
+			case 2: applyFood<FoodKind::Grape>(snake, random); break;
+			case 3: applyFood<FoodKind::Banana>(snake, random); break;
+			}
+		}
+		sink = snake.getPoints();
+	}) });
+
+	// Every cell of the board in turn, border excluded.
+	const std::uint32_t stride = static_cast<std::uint32_t>(snake.getOccupancy().getStride());
+	const std::uint32_t first = static_cast<std::uint32_t>(snake.getOccupancy().cellIndex(0, 0));
+	const std::uint32_t cells = static_cast<std::uint32_t>(game.getColumns() * game.getRows());
+	results.push_back({ "cell_decode", 0, measure(options, [] {}, [&](long long count) {
+		long long sum = 0;
+		for (long long i = 0; i < count; ++i) {
+			const std::uint32_t cell = first + static_cast<std::uint32_t>(i) % cells;
+			sum += static_cast<int>(cell % stride) - 1 + static_cast<int>(cell / stride) - 1;
+		}
+		sink = sum;
+	}) });
+
+	const std::size_t staticFirst = DefaultStaticBoard::index(0, 0);
+	results.push_back({ "cell_decode_static", 0, measure(options, [] {}, [&](long long count) {
+		long long sum = 0;
+		for (long long i = 0; i < count; ++i) {
+			const std::size_t cell = staticFirst + static_cast<std::size_t>(i) % DefaultStaticBoard::cells;
+			sum += DefaultStaticBoard::column(cell) + DefaultStaticBoard::row(cell);
+		}
+		sink = sum;
+	}) });
+}
+
+#if defined(SNAKE_BENCH_OFFSCREEN)
+// The playfield part of display_func(): clear, draw, and wait for the
+// rasterizer so the frame's whole cost is counted.
+void benchFrames(const Options& options, const std::vector<int>& lengths, std::vector<Result>& results) {
+	Game game;
+	OffscreenContext context;
+	if (!context.create(game.getColumns() * Renderer::segmentSize, game.getRows() * Renderer::segmentSize)) {
+		std::cerr << "no offscreen context, skipping frame benchmarks\n";
+		return;
+	}
+	glClearColor(0.3f, 0.5f, 0.2f, 0.5f);
+	Renderer renderer;
+	renderer.init(OffscreenContext::getProcAddress);
+
+	const Renderer::Mode modes[] = { Renderer::Mode::Batched, Renderer::Mode::Immediate };
+	const char* names[] = { "frame_batched", "frame_immediate" };
+	for (int m = 0; m < 2; ++m) {
+		if (modes[m] == Renderer::Mode::Batched && !renderer.canBatch()) {
+			continue;
+		}
+		renderer.setMode(modes[m]);
+		for (int length : lengths) {
+			buildSnake(game, length);
+			results.push_back({ names[m], length, measure(options, [] {}, [&](long long count) {
+				for (long long i = 0; i < count; ++i) {
+					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+					renderer.drawPlayfield(game);
+					glFinish();
+				}
+			}) });
+		}
+	}
+
+	// Incremental mode with the snake a cell further along every frame, a
+	// tick per frame, where the others draw the same frame over and over.
+	if (renderer.canDrawIncrementally()) {
+		renderer.setMode(Renderer::Mode::Incremental);
+		for (int length : lengths) {
+			buildSnake(game, length);
+			Snake& snake = game.getSnake();
+			renderer.drawPlayfield(game);
+			results.push_back({ "frame_incremental", length, measure(options, [] {}, [&](long long count) {
+				for (long long i = 0; i < count; ++i) {
+					followCycle(snake, game.getColumns(), game.getRows());
+					snake.move();
+					renderer.drawPlayfield(game);
+					glFinish();
+				}
+			}) });
+		}
+		renderer.setMode(Renderer::Mode::Batched);
+	}
+
+	// Streaming frames out, see FrameCapture: the readback, the conversion
+	// and a write to /dev/null, one capture() per frame.
+	const FrameCapture::Format formats[] = { FrameCapture::Format::Ppm, FrameCapture::Format::Y4m };
+	const char* captureNames[] = { "capture_ppm", "capture_y4m" };
+	for (int f = 0; f < 2; ++f) {
+		FrameCapture capture;
+		if (!capture.open(OffscreenContext::getProcAddress, "/dev/null", formats[f], context.getWidth(), context.getHeight(), 30)) {
+			break;
+		}
+		buildSnake(game, 1);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		renderer.drawPlayfield(game);
+		results.push_back({ captureNames[f], 0, measure(options, [] {}, [&](long long count) {
+			for (long long i = 0; i < count; ++i) {
+				capture.capture();
+			}
+		}) });
+		capture.close();
+	}
+	renderer.release();
+}
+#endif
+
+void writeResults(std::ostream& out, const std::vector<Result>& results) {
+	out << "[\n";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		char line[160];
+		std::snprintf(line, sizeof(line), "{\"name\": \"%s\", \"length\": %d, \"ns_per_op\": %.3f}", results[i].name.c_str(),
+			results[i].length, results[i].nsPerOp);
+		out << line << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "]\n";
+}
+
+// Reads the one-result-per-line format writeResults() produces.
+bool readResults(const std::string& path, std::vector<Result>& results) {
+	std::ifstream in(path);
+	if (!in) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		char name[64];
+		Result result;
+		if (std::sscanf(line.c_str(), " {\"name\": \"%63[^\"]\", \"length\": %d, \"ns_per_op\": %lf}", name, &result.length,
+			&result.nsPerOp) == 3) {
+			result.name = name;
+			results.push_back(result);
+		}
+	}
+	return true;
+}
+
+// Prints every result that moved by more than the tolerance and returns how
+// many got slower.
+int compareResults(const std::vector<Result>& baseline, const std::vector<Result>& results, double tolerance) {
+	int regressions = 0;
+	for (const Result& result : results) {
+		for (const Result& old : baseline) {
+			if (old.name != result.name || old.length != result.length || old.nsPerOp <= 0.0) {
+				continue;
+			}
+			const double change = 100.0 * (result.nsPerOp - old.nsPerOp) / old.nsPerOp;
+			if (change > tolerance || change < -tolerance) {
+				std::cerr << (change > 0.0 ? "slower: " : "faster: ") << result.name << " length " << result.length << ": "
+					<< old.nsPerOp << " -> " << result.nsPerOp << " ns (" << (change > 0.0 ? "+" : "") << change << "%)\n";
+				regressions += change > 0.0;
+			}
+		}
+	}
+	return regressions;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return EXIT_FAILURE;
+	}
+
+	std::vector<int> lengths;
+	const int cells = Game::defaultColumns * Game::defaultRows;
+	for (int length = 1; length < cells; length *= 2) {
+		lengths.push_back(length);
+	}
+	lengths.push_back(cells);
+
+	std::vector<Result> results;
+	benchSimulation(options, lengths, results);
+	benchRules(options, results);
+#if defined(SNAKE_BENCH_OFFSCREEN)
+	benchFrames(options, lengths, results);
+#endif
+
+	if (options.outPath.empty()) {
+		writeResults(std::cout, results);
+	}
+	else {
+		std::ofstream out(options.outPath);
+		writeResults(out, results);
+		if (!out) {
+			std::cerr << "error: cannot write " << options.outPath << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!options.baselinePath.empty()) {
+		std::vector<Result> baseline;
+		if (!readResults(options.baselinePath, baseline)) {
+			std::cerr << "error: cannot read " << options.baselinePath << "\n";
+			return EXIT_FAILURE;
+		}
+		const int regressions = compareResults(baseline, results, options.tolerance);
+		if (regressions != 0) {
+			std::cerr << "error: " << regressions << " results regressed by more than " << options.tolerance << "%\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
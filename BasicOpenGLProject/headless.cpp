@@ -0,0 +1,980 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "Arena.h"
+#include "Autopilot.h"
+#include "BatchEngine.h"
+#include "Bot.h"
+#include "FreeCells.h"
+#include "Game.h"
+#include "ParallelRunner.h"
+#include "Replay.h"
+#include "SimulationThread.h"
+#include "Snapshot.h"
+
+//=================================================================================================
+// HEADLESS RUNNER
+//=================================================================================================
+
+// Steps games without a window as fast as the CPU allows and reports the tick
+// rate. Used for soak runs, bots and benchmarks on machines without a display.
+//
+//   snake_headless [--policy P] [--games N] [--max-ticks N] [--seed N] [--check-allocs] [--record FILE]
+//   snake_headless --threads N [--policy P] [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --batch LANES [--scalar] [--verify] [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --decisions [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --check-food [--games N] [--seed N]
+//   snake_headless --check-input [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --check-snapshots [--snapshot-file FILE] [--check-allocs] [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --threaded [--tick-ms MS] [--slow-frames MS] [--slow-ticks MS] [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --arena SNAKES [--foods N] [--verify] [--check-allocs] [--games N] [--max-ticks N] [--seed N]
+//   snake_headless --replay FILE
+//
+// Game i is seeded with seed + i. --check-allocs fails the run if any tick,
+// food spawn or restart allocated; boards too large for a dense occupancy
+// bitmap do allocate, the first time the snake reaches a part of the board.
+// --record saves the first game as a replay; --replay plays one back at full
+// speed and fails unless it ends in exactly the recorded state.
+//
+// --threads spreads the games over N worker threads (0 for one per core)
+// instead of playing them one after another. --batch plays LANES games at a
+// time in lockstep on the SIMD BatchEngine (--scalar forces its fallback
+// path); --verify replays every game on Game and fails if any final state
+// differs. --policy picks the bot, greedy (the default) or autopilot; the
+// batch engine only runs greedy. --decisions plays the games with the
+// autopilot and times its decisions alone.
+//
+// --check-food fails unless food spawns uniformly over the free cells, with
+// and without the free cell index, and a snake steered along a Hamiltonian
+// cycle fills the board in each of the games with food on a free cell every
+// time; the board needs a multiple of 4 rows.
+//
+// --check-input plays the games with a player that presses bursts of random
+// direction keys between ticks, stamped on a simulated clock running at the
+// game's tick rate. It fails if a move ever reverses the snake or applies a
+// turn other than the oldest one queued, and reports how long turns waited
+// from key press to move.
+//
+// --check-snapshots plays the games with the greedy bot, keeping the last
+// 64 ticks in a SnapshotRing. Now and then it rolls back a random number of
+// ticks and replays them, and fails unless every replayed tick hashes as it
+// did the first time, rolling back out of game over included. Once per game
+// it saves a snapshot to a file, loads it into a second game and plays both
+// to the end, which must be the same. The file is --snapshot-file, by
+// default in the system's temporary directory, and is removed however the
+// check ends. --check-allocs fails the run if pushing onto the ring
+// allocated.
+//
+// --threaded plays the games the way the window does, on a SimulationThread
+// ticking every --tick-ms (default 1), while an input thread presses random
+// direction keys and this thread draws: it takes the newest frame whenever
+// there is one and restores it into a game of its own. It fails unless
+// every frame restores to exactly the published state, every key arrives
+// once and in order, and every game, recorded on the simulation thread,
+// replays to the same end. --slow-frames and --slow-ticks make every frame
+// or tick take that much longer, which must not slow the other thread down.
+// Build with SNAKE_TSAN to run it under ThreadSanitizer.
+//
+// --arena plays free for alls between SNAKES greedy bots with N pieces of
+// food (default 4) until every snake has crashed, and times Arena::update()
+// alone; --verify checks the arena's shared cell index against the bodies
+// and the food after every tick.
+//
+// Every mode but --replay also takes --columns N and --rows N for the board
+// size, up to Game::maxBoardSize; the default is the window's 27x20 board.
+
+namespace {
+
+struct Options {
+	int columns = Game::defaultColumns;
+	int rows = Game::defaultRows;
+	int games = 1000;
+	long long maxTicks = 100000; // per game, stops a bot that circles forever
+	std::uint64_t seed = 1;
+	bool checkAllocs = false;
+	std::string recordPath;
+	std::string replayPath;
+	std::string snapshotPath; // empty for the temporary directory
+	int threads = -1; // -1 plays the games on the main thread
+	int batchLanes = 0;
+	bool scalar = false;
+	bool verify = false;
+	Policy policy = Policy::Greedy;
+	bool decisions = false;
+	bool checkFood = false;
+	bool checkInput = false;
+	bool checkSnapshots = false;
+	bool threaded = false;
+	int tickMs = 1;
+	int slowFrameMs = 0;
+	int slowTickMs = 0;
+	int arenaSnakes = 0;
+	int arenaFoods = 4;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--columns") == 0 && hasValue) {
+			options.columns = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--rows") == 0 && hasValue) {
+			options.rows = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--games") == 0 && hasValue) {
+			options.games = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--max-ticks") == 0 && hasValue) {
+			options.maxTicks = std::atoll(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+			options.seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--check-allocs") == 0) {
+			options.checkAllocs = true;
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+			options.threads = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--batch") == 0 && hasValue) {
+			options.batchLanes = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--scalar") == 0) {
+			options.scalar = true;
+		}
+		else if (std::strcmp(argv[i], "--verify") == 0) {
+			options.verify = true;
+		}
+		else if (std::strcmp(argv[i], "--policy") == 0 && hasValue && std::strcmp(argv[i + 1], "greedy") == 0) {
+			options.policy = Policy::Greedy;
+			++i;
+		}
+		else if (std::strcmp(argv[i], "--policy") == 0 && hasValue && std::strcmp(argv[i + 1], "autopilot") == 0) {
+			options.policy = Policy::Autopilot;
+			++i;
+		}
+		else if (std::strcmp(argv[i], "--decisions") == 0) {
+			options.decisions = true;
+		}
+		else if (std::strcmp(argv[i], "--arena") == 0 && hasValue) {
+			options.arenaSnakes = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--foods") == 0 && hasValue) {
+			options.arenaFoods = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--check-food") == 0) {
+			options.checkFood = true;
+		}
+		else if (std::strcmp(argv[i], "--check-input") == 0) {
+			options.checkInput = true;
+		}
+		else if (std::strcmp(argv[i], "--check-snapshots") == 0) {
+			options.checkSnapshots = true;
+		}
+		else if (std::strcmp(argv[i], "--snapshot-file") == 0 && hasValue) {
+			options.snapshotPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--threaded") == 0) {
+			options.threaded = true;
+		}
+		else if (std::strcmp(argv[i], "--tick-ms") == 0 && hasValue) {
+			options.tickMs = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (std::strcmp(argv[i], "--slow-frames") == 0 && hasValue) {
+			options.slowFrameMs = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--slow-ticks") == 0 && hasValue) {
+			options.slowTickMs = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--record") == 0 && hasValue) {
+			options.recordPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) {
+			options.replayPath = argv[++i];
+		}
+		else {
+			std::cerr << "usage: " << argv[0] << " [--columns N] [--rows N] [--policy greedy|autopilot] [--games N] [--max-ticks N] [--seed N] [--check-allocs] [--record FILE]\n"
+				<< "       " << argv[0] << " --threads N [--policy greedy|autopilot] [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --batch LANES [--scalar] [--verify] [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --decisions [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --check-food [--games N] [--seed N]\n"
+				<< "       " << argv[0] << " --check-input [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --check-snapshots [--snapshot-file FILE] [--check-allocs] [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --threaded [--tick-ms MS] [--slow-frames MS] [--slow-ticks MS] [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --arena SNAKES [--foods N] [--verify] [--check-allocs] [--games N] [--max-ticks N] [--seed N]\n"
+				<< "       " << argv[0] << " --replay FILE\n";
+			return false;
+		}
+	}
+	if (options.columns < 1 || options.columns > Game::maxBoardSize || options.rows < 1 || options.rows > Game::maxBoardSize) {
+		std::cerr << "error: boards are 1 to " << Game::maxBoardSize << " cells on each side\n";
+		return false;
+	}
+	if (options.arenaSnakes < 0 || options.arenaSnakes > options.rows || options.arenaFoods < 0) {
+		std::cerr << "error: an arena has 1 to one snake per row and 0 or more pieces of food\n";
+		return false;
+	}
+	return true;
+}
+
+int playReplay(const std::string& path) {
+	Replay replay;
+	if (!replay.load(path)) {
+		std::cerr << "error: cannot read replay " << path << "\n";
+		return EXIT_FAILURE;
+	}
+	// The board comes from the file, not parseOptions().
+	if (replay.getColumns() < 1 || replay.getColumns() > Game::maxBoardSize || replay.getRows() < 1
+		|| replay.getRows() > Game::maxBoardSize) {
+		std::cerr << "error: boards are 1 to " << Game::maxBoardSize << " cells on each side\n";
+		return EXIT_FAILURE;
+	}
+
+	Game game(replay.getColumns(), replay.getRows(), replay.getSeed());
+	const auto start = std::chrono::steady_clock::now();
+	while (replay.apply(game)) {
+		game.update();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const bool match = game.stateHash() == replay.getEndHash();
+	std::cout << "ticks:          " << game.getTicks() << "\n";
+	std::cout << "seconds:        " << seconds << "\n";
+	std::cout << "ticks/second:   " << (seconds > 0.0 ? game.getTicks() / seconds : 0.0) << "\n";
+	std::cout << "score:          " << game.getPoints() << "\n";
+	std::cout << "end state:      " << (match ? "matches recording" : "DIFFERS from recording") << "\n";
+	return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void printSummary(const RunSummary& summary, double seconds) {
+	const double games = summary.games > 0 ? static_cast<double>(summary.games) : 1.0;
+	std::cout << "games:          " << summary.games << "\n";
+	std::cout << "ticks:          " << summary.ticks << "\n";
+	std::cout << "seconds:        " << seconds << "\n";
+	std::cout << "ticks/second:   " << (seconds > 0.0 ? summary.ticks / seconds : 0.0) << "\n";
+	std::cout << "average score:  " << summary.points / games << "\n";
+	std::cout << "average length: " << summary.length / games << "\n";
+	std::cout << "average ticks:  " << summary.ticks / games << "\n";
+	std::cout << "best score:     " << summary.bestPoints << "\n";
+	std::cout << "best length:    " << summary.bestLength << "\n";
+	std::cout << "win rate:       " << 100.0 * summary.wins / games << "%\n";
+}
+
+int runParallel(const Options& options) {
+	std::vector<GameJob> jobs;
+	jobs.reserve(options.games > 0 ? options.games : 0);
+	for (int i = 0; i < options.games; ++i) {
+		jobs.push_back({ options.seed + static_cast<std::uint64_t>(i), options.policy });
+	}
+
+	ParallelRunner runner(options.threads, options.columns, options.rows, options.maxTicks);
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<GameResult> results = runner.run(jobs);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	RunSummary summary;
+	for (const GameResult& result : results) {
+		summary.add(result);
+	}
+	std::cout << "threads:        " << runner.getThreadCount() << "\n";
+	printSummary(summary, seconds);
+	return EXIT_SUCCESS;
+}
+
+int runBatch(const Options& options) {
+	const std::size_t lanes = static_cast<std::size_t>(options.batchLanes);
+	BatchEngine engine(lanes, options.columns, options.rows);
+	engine.setTickLimit(options.maxTicks);
+	if (options.scalar) {
+		engine.setVectorized(false);
+	}
+
+	// Which game each lane is playing, -1 once there are none left.
+	std::vector<long long> laneGame(lanes, -1);
+	std::vector<char> inputs(lanes, 0);
+	std::vector<GameResult> results(options.games > 0 ? options.games : 0);
+	std::vector<std::uint64_t> hashes(results.size());
+	long long nextGame = 0;
+	std::size_t playing = 0;
+
+	auto startNext = [&](std::size_t lane) {
+		if (nextGame < static_cast<long long>(results.size())) {
+			laneGame[lane] = nextGame;
+			engine.reset(lane, options.seed + static_cast<std::uint64_t>(nextGame));
+			++nextGame;
+			++playing;
+		}
+		else {
+			laneGame[lane] = -1;
+		}
+	};
+	for (std::size_t lane = 0; lane < lanes; ++lane) {
+		startNext(lane);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	while (playing > 0) {
+		engine.greedyInputs(inputs.data());
+		if (engine.step(inputs.data()) == 0) {
+			continue;
+		}
+
+		for (std::size_t lane = 0; lane < lanes; ++lane) {
+			if (laneGame[lane] < 0 || engine.isPlaying(lane)) {
+				continue;
+			}
+			const long long game = laneGame[lane];
+			results[game] = { options.seed + static_cast<std::uint64_t>(game), engine.getPoints(lane),
+				engine.getFinalLength(lane), engine.getTicks(lane),
+				engine.getFinalLength(lane) == options.columns * options.rows };
+			hashes[game] = engine.stateHash(lane);
+			--playing;
+			startNext(lane);
+		}
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	RunSummary summary;
+	for (const GameResult& result : results) {
+		summary.add(result);
+	}
+	std::cout << "engine:         " << (engine.isVectorized() ? "avx2" : "scalar") << ", " << lanes << " lanes\n";
+	printSummary(summary, seconds);
+
+	if (options.verify) {
+		Game game(options.columns, options.rows);
+		Autopilot autopilot;
+		std::size_t mismatches = 0;
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const GameJob job = { results[i].seed, Policy::Greedy };
+			const GameResult expected = ParallelRunner::playGame(game, autopilot, job, options.maxTicks);
+			if (game.stateHash() != hashes[i] || expected.points != results[i].points || expected.ticks != results[i].ticks
+				|| expected.length != results[i].length) {
+				++mismatches;
+			}
+		}
+		std::cout << "mismatches:     " << mismatches << "\n";
+		if (mismatches != 0) {
+			std::cerr << "error: " << mismatches << " batch games differ from Game\n";
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+// The same games as a serial autopilot run, but only the time spent deciding
+// is counted, so the rate is the pathfinder's own.
+int runDecisions(const Options& options) {
+	Game game(options.columns, options.rows, options.seed);
+	Autopilot autopilot;
+	RunSummary summary;
+	long long decisions = 0;
+	double seconds = 0.0;
+	double slowest = 0.0;
+
+	for (int i = 0; i < options.games; ++i) {
+		game.newGame(options.seed + static_cast<std::uint64_t>(i));
+		int length = static_cast<int>(game.getSnake().getBody().size());
+		while (!game.isGameOver() && game.getTicks() < options.maxTicks) {
+			length = static_cast<int>(game.getSnake().getBody().size());
+			const auto start = std::chrono::steady_clock::now();
+			const char direction = autopilot.decide(game);
+			const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			seconds += elapsed;
+			slowest = elapsed > slowest ? elapsed : slowest;
+			++decisions;
+
+			game.getSnake().setDirection(direction);
+			game.update();
+		}
+		if (!game.isGameOver()) {
+			length = static_cast<int>(game.getSnake().getBody().size());
+		}
+		summary.add({ game.getSeed(), game.getPoints(), length, game.getTicks(), length == game.getColumns() * game.getRows() });
+	}
+
+	printSummary(summary, seconds);
+	std::cout << "decisions/s:    " << (seconds > 0.0 ? decisions / seconds : 0.0) << "\n";
+	std::cout << "mean decision:  " << (decisions > 0 ? 1e6 * seconds / decisions : 0.0) << " us\n";
+	std::cout << "slowest:        " << 1e6 * slowest << " us\n";
+	return EXIT_SUCCESS;
+}
+
+// Draws spawns picks from free cells whose snake is snake, counting them per
+// cell, and checks the counts against a uniform spread with a chi-squared
+// test. Fails on any spawn under the body.
+bool checkUniform(const char* label, const FreeCells& free, const Snake& snake, Random& random, int draws) {
+	const OccupancyGrid& occupancy = snake.getOccupancy();
+	const int columns = occupancy.getColumns();
+	std::vector<int> counts(static_cast<std::size_t>(columns) * occupancy.getRows(), 0);
+	for (int i = 0; i < draws; ++i) {
+		int x, y;
+		if (!free.pick(random, [&](int cx, int cy) { return occupancy.test(cx, cy); }, x, y) || occupancy.test(x, y)) {
+			std::cerr << "error: " << label << ": food spawned on the body\n";
+			return false;
+		}
+		++counts[static_cast<std::size_t>(y) * columns + x];
+	}
+
+	const double expected = static_cast<double>(draws) / free.size();
+	double chiSquared = 0.0;
+	for (std::size_t cell = 0; cell < counts.size(); ++cell) {
+		if (!occupancy.test(static_cast<int>(cell % columns), static_cast<int>(cell / columns))) {
+			chiSquared += (counts[cell] - expected) * (counts[cell] - expected) / expected;
+		}
+	}
+	// About six standard deviations above the mean of the distribution.
+	const double freedom = static_cast<double>(free.size() - 1);
+	const double limit = freedom + 6.0 * std::sqrt(2.0 * freedom) + 6.0;
+	std::cout << label << ": " << free.size() << " free cells, chi squared " << chiSquared << " (limit " << limit << ")\n";
+	if (chiSquared > limit) {
+		std::cerr << "error: " << label << ": food does not spawn uniformly\n";
+		return false;
+	}
+	return true;
+}
+
+int runFoodCheck(const Options& options) {
+	if (options.rows % 4 != 0) {
+		std::cerr << "error: --check-food needs a multiple of 4 rows\n";
+		return EXIT_FAILURE;
+	}
+
+	// Uniformity on a small board, so every cell gets many spawns: the index
+	// the game uses, then the fallback for huge boards with a snake that
+	// leaves room, and with one that leaves so little that random tries miss
+	// and it has to scan.
+	const int smallColumns = 8;
+	const int smallRows = 8;
+	Game small(smallColumns, smallRows, options.seed);
+	Random random(options.seed);
+	bool ok = true;
+	for (int length : { 20, 62 }) {
+		Snake& snake = small.getSnake();
+		snake.reset();
+		while (static_cast<int>(snake.getBody().size()) < length && !snake.hasCrashed()) {
+			snake.grow();
+			snake.setDirection(cycleDirection(snake.getHead().x, snake.getHead().y, smallColumns, smallRows));
+			snake.move();
+		}
+		FreeCells counted(smallColumns, smallRows, false);
+		for (const SnakeSegment& segment : snake.getBody()) {
+			counted.take(segment.x, segment.y);
+		}
+		const int draws = 20000 * static_cast<int>(counted.size());
+		ok = checkUniform(length == 20 ? "indexed" : "indexed, nearly full", snake.getFreeCells(), snake, random, draws) && ok;
+		ok = checkUniform(length == 20 ? "counted" : "counted, nearly full", counted, snake, random, draws) && ok;
+	}
+
+	// Fill the whole board.
+	Game game(options.columns, options.rows, options.seed);
+	const long long cells = static_cast<long long>(options.columns) * options.rows;
+	long long ticks = 0;
+	int filled = 0;
+	for (int i = 0; i < options.games && ok; ++i) {
+		game.newGame(options.seed + static_cast<std::uint64_t>(i));
+		const Snake& snake = game.getSnake();
+		while (!game.isGameOver() && game.getFood() && game.getTicks() < cells * cells) {
+			game.getSnake().setDirection(cycleDirection(snake.getHead().x, snake.getHead().y, options.columns, options.rows));
+			game.update();
+			const Food* food = game.getFood();
+			if (food && snake.isOccupied(food->getX(), food->getY())) {
+				std::cerr << "error: game " << game.getSeed() << ": food spawned on the body on tick " << game.getTicks() << "\n";
+				ok = false;
+				break;
+			}
+		}
+		ticks += game.getTicks();
+		if (ok && (game.isGameOver() || game.getFood() || static_cast<long long>(snake.getBody().size()) != cells)) {
+			std::cerr << "error: game " << game.getSeed() << " did not fill the board\n";
+			ok = false;
+		}
+		filled += ok;
+	}
+	std::cout << "filled:         " << filled << " of " << options.games << " boards of " << options.columns << "x" << options.rows
+		<< " in " << ticks << " ticks\n";
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool isOpposite(char direction, char other) {
+	return (direction == 'w' && other == 's') || (direction == 's' && other == 'w') || (direction == 'a' && other == 'd')
+		|| (direction == 'd' && other == 'a');
+}
+
+int runInputCheck(const Options& options) {
+	const char keys[] = { 'w', 'a', 's', 'd' };
+	Game game(options.columns, options.rows, options.seed);
+	Random random(options.seed);
+	std::vector<InputEvent> queued; // turns setDirection() accepted, oldest first
+	std::vector<std::uint64_t> offsets;
+	std::vector<double> latencies; // ms
+	long long presses = 0, accepted = 0, dropped = 0;
+	std::uint64_t now = 0; // simulated ns
+
+	for (int i = 0; i < options.games; ++i) {
+		game.newGame(options.seed + static_cast<std::uint64_t>(i));
+		queued.clear();
+		const Snake& snake = game.getSnake();
+		while (!game.isGameOver() && game.getTicks() < options.maxTicks) {
+			const std::uint64_t interval = static_cast<std::uint64_t>(game.getTickInterval()) * 1000000;
+			// A burst of one to four keys before one tick in three.
+			offsets.clear();
+			if (random.nextBelow(3) == 0) {
+				for (std::uint32_t key = random.nextBelow(4) + 1; key > 0; --key) {
+					offsets.push_back(random.nextBelow(static_cast<std::uint32_t>(interval)));
+				}
+				std::sort(offsets.begin(), offsets.end());
+			}
+			for (std::uint64_t offset : offsets) {
+				const InputEvent event = { keys[random.nextBelow(4)], now + offset + 1 };
+				const bool full = snake.getInputs().full();
+				++presses;
+				if (game.getSnake().setDirection(event.direction, event.time)) {
+					queued.push_back(event);
+					++accepted;
+				}
+				dropped += full;
+			}
+			now += interval;
+
+			const char before = snake.getDirection();
+			game.update();
+			const char after = snake.getDirection();
+			if (isOpposite(after, before)) {
+				std::cerr << "error: game " << game.getSeed() << ": the snake reversed on tick " << game.getTicks() << "\n";
+				return EXIT_FAILURE;
+			}
+			if (queued.empty()) {
+				if (snake.getAppliedInputTime() != 0) {
+					std::cerr << "error: game " << game.getSeed() << ": a turn nobody queued was applied on tick " << game.getTicks() << "\n";
+					return EXIT_FAILURE;
+				}
+				continue;
+			}
+			if (after != queued.front().direction || snake.getAppliedInputTime() != queued.front().time) {
+				std::cerr << "error: game " << game.getSeed() << ": tick " << game.getTicks() << " did not apply the oldest queued turn\n";
+				return EXIT_FAILURE;
+			}
+			latencies.push_back((now - queued.front().time) / 1e6);
+			queued.erase(queued.begin());
+		}
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	double mean = 0.0;
+	for (double latency : latencies) {
+		mean += latency;
+	}
+	const std::size_t count = latencies.size();
+	std::cout << "key presses:    " << presses << ", " << accepted << " turns queued, " << dropped << " dropped on a full queue\n";
+	std::cout << "turns applied:  " << count << ", in order, none reversing\n";
+	if (count > 0) {
+		std::cout << "latency:        mean " << mean / count << " ms, p50 " << latencies[count / 2] << " ms, p99 "
+			<< latencies[count * 99 / 100] << " ms, max " << latencies.back() << " ms\n";
+	}
+	return EXIT_SUCCESS;
+}
+
+// Plays game to the end with the greedy bot.
+void playOut(Game& game, long long maxTicks) {
+	while (!game.isGameOver() && game.getTicks() < maxTicks) {
+		game.getSnake().setDirection(greedyDirection(game));
+		game.update();
+	}
+}
+
+// Deletes the file when the check returns, passed or not.
+struct RemoveFile {
+	std::string path;
+	~RemoveFile() { std::remove(path.c_str()); }
+};
+
+int runSnapshotCheck(const Options& options) {
+	std::string path = options.snapshotPath;
+	if (path.empty()) {
+		std::error_code error;
+		const std::filesystem::path directory = std::filesystem::temp_directory_path(error);
+		path = (error ? std::filesystem::path("snake_snapshot_check.snks") : directory / "snake_snapshot_check.snks").string();
+	}
+	const RemoveFile removeFile = { path };
+	Game game(options.columns, options.rows, options.seed);
+	Game branch(options.columns, options.rows, options.seed);
+	SnapshotRing ring(64, options.columns, options.rows);
+	Snapshot saved(Snapshot::maxSize(options.columns, options.rows));
+	Snapshot loaded;
+	Random random(options.seed);
+	std::vector<std::uint64_t> hashes; // by tick
+	long long rollbacks = 0, replayedTicks = 0, pushes = 0;
+	std::size_t allocations = 0, largest = 0;
+	double pushSeconds = 0.0, rollbackSeconds = 0.0;
+
+	for (int i = 0; i < options.games; ++i) {
+		game.newGame(options.seed + static_cast<std::uint64_t>(i));
+		ring.clear();
+		hashes.assign(1, game.stateHash());
+		const long long saveTick = random.nextBelow(200);
+		bool branched = false;
+
+		auto push = [&]() {
+			const std::size_t allocationsBefore = allocationCount();
+			const auto start = std::chrono::steady_clock::now();
+			ring.push(game);
+			pushSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			allocations += allocationCount() - allocationsBefore;
+			largest = std::max(largest, ring.get(0).size());
+			++pushes;
+		};
+		// Through a file into the second game, the first time the game is on
+		// saveTick or over.
+		auto branchHere = [&]() {
+			saved.capture(game);
+			branched = true;
+			return saved.save(path) && loaded.load(path) && loaded.restore(branch);
+		};
+		push();
+		while (game.getTicks() < options.maxTicks) {
+			if (!branched && (game.getTicks() == saveTick || game.isGameOver()) && !branchHere()) {
+				std::cerr << "error: game " << game.getSeed() << ": cannot save and load a snapshot on tick " << game.getTicks() << "\n";
+				return EXIT_FAILURE;
+			}
+			if (!game.isGameOver()) {
+				game.getSnake().setDirection(greedyDirection(game));
+				game.update();
+				hashes.resize(static_cast<std::size_t>(game.getTicks()));
+				hashes.push_back(game.stateHash());
+				push();
+			}
+
+			// Back a few ticks and forward again, always out of game over.
+			if (ring.size() > 1 && (game.isGameOver() || random.nextBelow(16) == 0)) {
+				const std::size_t back = 1 + random.nextBelow(static_cast<std::uint32_t>(ring.size() - 1));
+				const long long target = game.getTicks() - static_cast<long long>(back);
+				const auto start = std::chrono::steady_clock::now();
+				const bool restored = ring.rollback(game, back);
+				rollbackSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				++rollbacks;
+				if (!restored || game.getTicks() != target || game.stateHash() != hashes[static_cast<std::size_t>(target)]) {
+					std::cerr << "error: game " << game.getSeed() << ": rolling back to tick " << target << " did not restore it\n";
+					return EXIT_FAILURE;
+				}
+				for (std::size_t step = 0; step < back; ++step) {
+					game.getSnake().setDirection(greedyDirection(game));
+					game.update();
+					push();
+					++replayedTicks;
+					if (game.stateHash() != hashes[static_cast<std::size_t>(game.getTicks())]) {
+						std::cerr << "error: game " << game.getSeed() << ": tick " << game.getTicks() << " differs after a rollback\n";
+						return EXIT_FAILURE;
+					}
+				}
+				if (game.isGameOver()) {
+					break;
+				}
+			}
+		}
+
+		if (!branched && !branchHere()) {
+			std::cerr << "error: game " << game.getSeed() << ": cannot save and load a snapshot on tick " << game.getTicks() << "\n";
+			return EXIT_FAILURE;
+		}
+		playOut(branch, options.maxTicks);
+		if (branch.stateHash() != game.stateHash()) {
+			std::cerr << "error: game " << game.getSeed() << ": the game loaded from a snapshot ended differently" << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::cout << "snapshots:      " << pushes << " pushed, at most " << largest << " bytes, "
+		<< (pushes > 0 ? 1e9 * pushSeconds / pushes : 0.0) << " ns each\n";
+	std::cout << "rollbacks:      " << rollbacks << ", " << (rollbacks > 0 ? 1e9 * rollbackSeconds / rollbacks : 0.0)
+		<< " ns each, " << replayedTicks << " ticks replayed identically\n";
+	std::cout << "branches:       " << options.games << " games loaded from a file ended the same\n";
+	std::cout << "allocations:    " << allocations << " while pushing\n";
+	if (options.checkAllocs && allocations != 0) {
+		std::cerr << "error: pushing snapshots allocated " << allocations << " times\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int runThreadedCheck(const Options& options) {
+	// Simulation thread state: the game, its recording, and a second game
+	// to replay each finished one on. Read here only after stop().
+	Game game(options.columns, options.rows, options.seed);
+	Game replayed(options.columns, options.rows);
+	Replay replay;
+	int gamesPlayed = 0, replayMismatches = 0;
+	std::uint64_t lastKey = 0, keysOutOfOrder = 0;
+	replay.begin(game);
+
+	// Keys carry a count as their time, so the handler can tell one went
+	// missing or came twice.
+	SimulationThread simulation(game,
+		[&](Game& game, const SimulationThread::Command& command) {
+			keysOutOfOrder += command.time != lastKey + 1;
+			lastKey = command.time;
+			replay.record(static_cast<std::uint64_t>(game.getTicks()), command.key);
+			game.getSnake().setDirection(command.key, command.time);
+		},
+		[&](Game& game, FixedTimestep&) {
+			if (options.slowTickMs > 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(options.slowTickMs));
+			}
+			game.update();
+			if (!game.isGameOver() && game.getTicks() < options.maxTicks) {
+				return true;
+			}
+			replay.finish(game);
+			replayed.newGame(replay.getSeed());
+			while (replay.apply(replayed)) {
+				replayed.update();
+			}
+			replayMismatches += replayed.stateHash() != replay.getEndHash();
+			if (++gamesPlayed == options.games) {
+				return false;
+			}
+			game.newGame(options.seed + static_cast<std::uint64_t>(gamesPlayed));
+			replay.begin(game);
+			return true;
+		});
+	simulation.setTickMs(options.tickMs);
+
+	// Input thread: bursts of one to four keys, a tick or so apart.
+	std::atomic<bool> done(false);
+	long long keysPosted = 0, keysDropped = 0;
+	std::thread input([&] {
+		const char keys[] = { 'w', 'a', 's', 'd' };
+		Random random(options.seed);
+		while (!done.load(std::memory_order_acquire)) {
+			for (std::uint32_t key = random.nextBelow(4) + 1; key > 0; --key) {
+				if (simulation.post({ keys[random.nextBelow(4)], static_cast<std::uint64_t>(keysPosted + 1) })) {
+					++keysPosted;
+				}
+				else {
+					++keysDropped;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(random.nextBelow(2000 * options.tickMs) + 1));
+		}
+	});
+
+	// This thread draws.
+	Game view(options.columns, options.rows, 1, false);
+	Snapshot restored(Snapshot::maxSize(options.columns, options.rows));
+	long long frames = 0, newFrames = 0, lastSequence = 0, badFrames = 0;
+	double maxFrameMs = 0.0;
+	const auto start = std::chrono::steady_clock::now();
+	simulation.start();
+	while (simulation.isRunning()) {
+		const auto frameStart = std::chrono::steady_clock::now();
+		if (simulation.acquire()) {
+			const SimulationThread::Frame& frame = simulation.getFrame();
+			bool good = frame.sequence > lastSequence && frame.state.restore(view);
+			if (good) {
+				restored.capture(view, Snapshot::Contents::Display);
+				good = restored.size() == frame.state.size() && std::memcmp(restored.data(), frame.state.data(), restored.size()) == 0;
+			}
+			badFrames += !good;
+			lastSequence = frame.sequence;
+			++newFrames;
+		}
+		const float alpha = simulation.getAlpha(std::chrono::steady_clock::now());
+		badFrames += alpha < 0.0f || alpha > 1.0f;
+		++frames;
+		maxFrameMs = std::max(maxFrameMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		std::this_thread::sleep_for(std::chrono::milliseconds(options.slowFrameMs) + std::chrono::microseconds(250));
+	}
+	done.store(true, std::memory_order_release);
+	input.join();
+	simulation.stop();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const FixedTimestep& timestep = simulation.getTimestep();
+	std::cout << "games:          " << gamesPlayed << ", " << gamesPlayed - replayMismatches << " replayed to the same end\n";
+	std::cout << "ticks:          " << simulation.getTicks() << ", " << simulation.getTicks() / seconds << " a second at " << options.tickMs
+		<< " ms, jitter mean " << timestep.getJitterMeanMs() << " ms, max " << timestep.getJitterMaxMs() << " ms\n";
+	std::cout << "frames:         " << frames << ", " << frames / seconds << " a second, " << newFrames << " with a new tick, "
+		<< badFrames << " bad, max " << maxFrameMs << " ms drawing\n";
+	std::cout << "keys:           " << keysPosted << " posted, " << simulation.getCommands() << " applied, " << keysOutOfOrder
+		<< " out of order, " << keysDropped << " dropped on a full queue\n";
+
+	// Keys posted after the last game ended are still queued.
+	const long long keysLost = keysPosted - simulation.getCommands();
+	if (badFrames != 0 || replayMismatches != 0 || keysOutOfOrder != 0 || keysLost < 0
+		|| keysLost > static_cast<long long>(SimulationThread::commandCapacity)) {
+		std::cerr << "error: the simulation and render threads disagree\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// The arena's index must hold exactly the living bodies, and food only on
+// cells no snake is on.
+bool checkArena(const Arena& arena) {
+	long long bodies = 0;
+	for (std::size_t i = 0; i < arena.getSnakeCount(); ++i) {
+		if (!arena.isAlive(i)) {
+			continue;
+		}
+		for (const SnakeSegment& segment : arena.getSnake(i).getBody()) {
+			if (!arena.isBlocked(segment.x, segment.y)) {
+				return false;
+			}
+			++bodies;
+		}
+	}
+	long long blocked = 0;
+	for (int y = 0; y < arena.getRows(); ++y) {
+		for (int x = 0; x < arena.getColumns(); ++x) {
+			blocked += arena.isBlocked(x, y);
+		}
+	}
+	for (std::size_t item = 0; item < arena.getFoodCount(); ++item) {
+		const Food* food = arena.getFood(item);
+		if (food && arena.isBlocked(food->getX(), food->getY())) {
+			return false;
+		}
+	}
+	return blocked == bodies;
+}
+
+int runArena(const Options& options) {
+	Arena arena(options.columns, options.rows, options.arenaSnakes, options.arenaFoods, options.seed);
+	RunSummary summary;
+	long long ticks = 0;
+	long long moves = 0; // heads moved, one per living snake per tick
+	long long survivors = 0;
+	double seconds = 0.0;
+
+	const std::size_t allocationsBefore = allocationCount();
+	for (int i = 0; i < options.games; ++i) {
+		arena.newGame(options.seed + static_cast<std::uint64_t>(i));
+		while (!arena.isOver() && arena.getTicks() < options.maxTicks) {
+			for (std::size_t snake = 0; snake < arena.getSnakeCount(); ++snake) {
+				if (arena.isAlive(snake)) {
+					arena.getSnake(snake).setDirection(greedyDirection(arena, snake));
+				}
+			}
+			moves += static_cast<long long>(arena.getAliveCount());
+			const auto start = std::chrono::steady_clock::now();
+			arena.update();
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (options.verify && !checkArena(arena)) {
+				std::cerr << "error: arena " << arena.getSeed() << ": the cell index disagrees with the board on tick "
+					<< arena.getTicks() << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+		ticks += arena.getTicks();
+		survivors += static_cast<long long>(arena.getAliveCount());
+		for (std::size_t snake = 0; snake < arena.getSnakeCount(); ++snake) {
+			const Snake& s = arena.getSnake(snake);
+			const int length = static_cast<int>(s.getBody().size());
+			summary.add({ arena.getSeed(), s.getPoints(), length, arena.getTicks(), false });
+		}
+	}
+	const std::size_t allocations = allocationCount() - allocationsBefore;
+
+	const double games = options.games > 0 ? options.games : 1;
+	std::cout << "arenas:         " << options.games << " of " << options.arenaSnakes << " snakes, " << options.arenaFoods << " food\n";
+	std::cout << "ticks:          " << ticks << "\n";
+	std::cout << "update seconds: " << seconds << "\n";
+	std::cout << "ticks/second:   " << (seconds > 0.0 ? ticks / seconds : 0.0) << "\n";
+	std::cout << "ns per head:    " << (moves > 0 ? 1e9 * seconds / moves : 0.0) << "\n";
+	std::cout << "average ticks:  " << ticks / games << "\n";
+	std::cout << "survivors:      " << survivors / games << " per arena at the tick limit\n";
+	std::cout << "best score:     " << summary.bestPoints << "\n";
+	std::cout << "allocations:    " << allocations << "\n";
+	if (options.verify) {
+		std::cout << "index:          matches the board on every tick\n";
+	}
+	if (options.checkAllocs && allocations != 0) {
+		std::cerr << "error: the arena allocated " << allocations << " times\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return EXIT_FAILURE;
+	}
+	if (!options.replayPath.empty()) {
+		return playReplay(options.replayPath);
+	}
+
+	if (options.batchLanes > 0) {
+		return runBatch(options);
+	}
+	if (options.threads >= 0) {
+		return runParallel(options);
+	}
+
+	if (options.decisions) {
+		return runDecisions(options);
+	}
+	if (options.checkFood) {
+		return runFoodCheck(options);
+	}
+	if (options.checkInput) {
+		return runInputCheck(options);
+	}
+	if (options.checkSnapshots) {
+		return runSnapshotCheck(options);
+	}
+	if (options.threaded) {
+		return runThreadedCheck(options);
+	}
+	if (options.arenaSnakes > 0) {
+		return runArena(options);
+	}
+
+	Game game(options.columns, options.rows, options.seed);
+	Autopilot autopilot;
+	Replay replay;
+	const bool recording = !options.recordPath.empty();
+	RunSummary summary;
+
+	// The autopilot sizes its bitboards on the first decision.
+	autopilot.decide(game);
+	const std::size_t allocationsBefore = allocationCount();
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < options.games; ++i) {
+		const GameJob job = { options.seed + static_cast<std::uint64_t>(i), options.policy };
+		summary.add(ParallelRunner::playGame(game, autopilot, job, options.maxTicks, recording && i == 0 ? &replay : nullptr));
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const std::size_t allocations = allocationCount() - allocationsBefore;
+
+	printSummary(summary, seconds);
+	std::cout << "allocations:    " << allocations << "\n";
+
+	if (recording && !replay.save(options.recordPath)) {
+		std::cerr << "error: cannot write replay " << options.recordPath << "\n";
+		return EXIT_FAILURE;
+	}
+
+	if (options.checkAllocs && allocations != 0) {
+		std::cerr << "error: the game loop allocated " << allocations << " times\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,10 +1,28 @@
 #include <GL/freeglut.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
-#include <vector>
 #include <cstdlib>
-#include <queue>
+#include <memory>
 #include <string>
 
+#include "AllocationCounter.h"
+#include "Arena.h"
+#include "Autopilot.h"
+#include "Bot.h"
+#include "FixedTimestep.h"
+#include "FrameCapture.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include "SimulationThread.h"
+#include "Snapshot.h"
+#include "Game.h"
+#include "Renderer.h"
+#include "TextRenderer.h"
+
 //=================================================================================================
 // CALLBACKS
 //=================================================================================================
@@ -15,359 +33,313 @@
 // http://freeglut.sourceforge.net/docs/api.php#WindowCallback
 //-----------------------------------------------------------------------------
 
-int points = 0;
-bool gameOver = false;
-int snakeSpeed = 95;
-const int segmentSize = 30;
+const int segmentSize = Renderer::segmentSize;
+
+// --columns N and --rows N size the board, larger boards than the window
+// scroll with the head.
+//
+// The single snake game ticks on a SimulationThread: game, and everything
+// update() and handleKey() touch, belongs to that thread while it runs.
+// GLUT's thread forwards keys to it and draws view, the newest frame it
+// published restored into a game of our own. The arena still ticks here,
+// from idle_func(), on timestep.
+std::unique_ptr<Game> game;
+std::unique_ptr<Game> view;
+Renderer renderer;
+// The game over screen's font and the HUD's, see the labels under RENDERING.
+TextRenderer largeText, smallText;
+FixedTimestep timestep;
+int windowWidth = 0, windowHeight = 0;
+
+// --check-allocs: report any gameplay frame or tick that touched the heap.
+// The count is for the whole process, so either thread can trip the other.
+bool checkAllocs = false;
+// Print the draw call count of the next frame, set when the render mode changes.
+bool reportRenderMode = true;
+// --immediate: start with the glBegin/glEnd fallback renderer; --incremental:
+// start repainting only the cells that changed, see Renderer.
+Renderer::Mode startMode = Renderer::Mode::Batched;
+
+// --capture FILE streams every frame drawn to FILE, which can be a named pipe
+// (standard output has the game's messages on it), as 60 fps Y4M for a .y4m
+// file and PPM images otherwise; see FrameCapture.
+// The capture keeps the size the window opened with. Exit with 'e' to keep
+// the last few frames, which are still being read back.
+FrameCapture capture;
+std::string capturePath;
+
+// --record FILE saves every finished game over FILE, --replay FILE plays one
+// back at normal speed instead of taking direction keys.
+Replay replay;
+std::string recordPath;
+bool playingReplay = false;
+
+// The last ticks of the single snake game, 'z' rewinds rewindTicks of them,
+// out of game over too. 'k' saves the game to snapshotPath (--snapshot
+// FILE) and 'l' loads it back. Not while recording or playing a replay,
+// whose ticks must run forward.
+std::unique_ptr<SnapshotRing> history;
+const std::size_t historyTicks = 256;
+const std::size_t historyBytes = std::size_t(64) << 20; // fewer ticks on huge boards
+const std::size_t rewindTicks = 20;
+std::string snapshotPath = "snake_snapshot.snks";
+
+// 'p' or --autopilot: demo mode, the autopilot steers instead of the keys.
+Autopilot autopilot;
+bool autopilotEnabled = false;
+
+// --arena N plays snake 0 against N - 1 greedy bots on one board, with
+// --foods M pieces of food on it, instead of the single snake game. The game
+// is over when snake 0 is out.
+std::unique_ptr<Arena> arena;
+
+// Declared after game so it is destroyed, and its thread joined, first.
+std::unique_ptr<SimulationThread> simulation;
+
+// The game as drawn, for GLUT's thread.
+bool isGameOver() {
+	return arena ? !arena->isAlive(0) : view->isGameOver();
+}
 
-struct SnakeSegment {
-	int x, y;
-};
+int getTickInterval() {
+	return arena ? arena->getTickInterval() : view->getTickInterval();
+}
 
+int getPoints() {
+	return arena ? arena->getSnake(0).getPoints() : view->getPoints();
+}
 
-class Snake {
-private:
-	std::vector<SnakeSegment> segment;
-	std::queue<char> directions;
-	static const int segmentSize = 30;
-	float r, g, b;
-	char lastDirection;
-public:
-	Snake(int startX, int startY) : r(1.0f), g(1.0f), b(1.0f), lastDirection('d') {
-		segment.push_back({ startX, startY });
+#if defined(SNAKE_PROFILING)
+// 'h' shows the tick and frame timings over the game, 'j' and exiting write
+// them to profilePath (--profile FILE).
+bool showProfile = false;
+std::string profilePath = "snake_profile.json";
+
+void writeProfile() {
+	std::ofstream out(profilePath);
+	Profiler::writeJson(out);
+	if (out) {
+		std::cout << "Profile saved to " << profilePath << "\n";
 	}
-
-	~Snake() {}
-
-	void reset() {
-		segment.clear(); // Clear all segments
-		segment.push_back({ 405, 315 }); // Reset to initial position
-
-		directions = std::queue<char>(); // Clear direction queue
-		lastDirection = 'd'; // Reset last direction
-		snakeSpeed = 95; // Reset speed
-		r = 1.0f;
-		g = 1.0f;
-		b = 1.0f;
+	else {
+		std::cerr << "Cannot write profile " << profilePath << "\n";
 	}
+}
+#endif
 
-	void move() {
-		char direction;
-
-		if (!directions.empty()) {
-			direction = directions.front();
-			directions.pop();
-			lastDirection = direction;
-		}
-		else {
-			direction = lastDirection;
-		}
-
-		if (!segment.empty()) {
-			int newX = segment.front().x;
-			int newY = segment.front().y;
-
-			switch (direction) {
-			case 'w':
-				newY += segmentSize;
-				break;
-
-			case 'a':
-				newX -= segmentSize;
-				break;
-			case 's':
-				newY -= segmentSize;
-				break;
-
-			case 'd':
-				newX += segmentSize;
-				break;
-			}
+GLProc getProcAddress(const char* name) {
+	return reinterpret_cast<GLProc>(glutGetProcAddress(name));
+}
 
+// GLUT's font calls for BitmapFont, wrapped since their calling convention
+// may not be the default one.
+void drawGlutCharacter(void* font, int character) {
+	glutBitmapCharacter(font, character);
+}
 
-			segment.insert(segment.begin(), { newX, newY });
-			segment.pop_back();
-		}
+int glutCharacterWidth(void* font, int character) {
+	return glutBitmapWidth(font, character);
+}
 
+void startGame(std::uint64_t seed) {
+	if (arena) {
+		arena->newGame(seed);
+		std::cout << "Seed:           " << seed << "\n";
+		return;
 	}
-
-	void grow() {
-		int tailX = segment.back().x;
-		int tailY = segment.back().y;
-
-		switch (lastDirection) {
-		case 'w':
-			segment.push_back({ tailX, tailY + segmentSize });
-			break;
-		case 'a':
-			segment.push_back({ tailX + segmentSize, tailY });
-			break;
-		case 's':
-			segment.push_back({ tailX, tailY - segmentSize });
-			break;
-		case 'd':
-			segment.push_back({ tailX - segmentSize, tailY });
-			break;
-		}
+	if (playingReplay) {
+		game->newGame(replay.getSeed());
+		replay.rewind();
+		return;
 	}
 
-	void setDirection(char newDirection) {
-		if ((newDirection == 'w' && lastDirection != 's') || (newDirection == 'a' && lastDirection != 'd') || (newDirection == 's' && lastDirection != 'w')
-			|| (newDirection == 'd' && lastDirection != 'a')) {
-			directions.push(newDirection);
-			lastDirection = newDirection;
-		}
+	game->newGame(seed);
+	std::cout << "Seed:           " << seed << "\n";
+	if (!recordPath.empty()) {
+		replay.begin(*game);
 	}
-
-	void changeColorToRandom() {
-		r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-		g = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-		b = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-
+	if (history) {
+		history->clear();
+		history->push(*game);
 	}
+}
 
-	float getRed() const { return r; }
-	float getGreen() const { return g; }
-	float getBlue() const { return b; }
-
-	std::vector<SnakeSegment> getSegments() const {
-		return segment;
+void rewind() {
+	if (!history || history->size() < 2) {
+		return;
 	}
+	const std::size_t back = std::min(rewindTicks, history->size() - 1);
+	if (history->rollback(*game, back)) {
+		std::cout << "Rewound to tick " << game->getTicks() << "\n";
+	}
+}
 
-};
-
-Snake snake(405, 315);
-
-void handleGameOver() {
-
-	gameOver = true;
-	snake.reset(); //Reset the snake because it was blocking the display screen
+void saveSnapshot() {
+	if (!history) {
+		return;
+	}
+	Snapshot snapshot;
+	snapshot.capture(*game);
+	if (snapshot.save(snapshotPath)) {
+		std::cout << "Game saved to " << snapshotPath << " (" << snapshot.size() << " bytes)\n";
+	}
+	else {
+		std::cerr << "Cannot write snapshot " << snapshotPath << "\n";
+	}
 }
 
-class GameObject {
-public:
-	virtual void draw() const = 0;
-	virtual void foodEffect() const = 0;
-	virtual ~GameObject() {}
-};
-
-
-class Food : public GameObject {
-protected:
-	int x, y;
-	static const int segmentSize = 30;
-public:
-	Food() : x(0), y(0) {}
-	~Food() {}
-	virtual void placeRandom(int maxX, int maxY) {
-		int cellX = rand() % (maxX / segmentSize);
-		int cellY = rand() % (maxY / segmentSize);
-
-		// Set food position to the center of the chosen cell
-		x = cellX * segmentSize + segmentSize / 2;
-		y = cellY * segmentSize + segmentSize / 2;
-	}
-
-	virtual void draw() const = 0;
-	virtual void foodEffect() const = 0;
-	virtual int getX() const { return x; }
-	virtual int getY() const { return y; }
-};
-
-
-class Apple : public Food {
-public:
-	void draw() const override {
-		const float size = 30.0f;
-		glColor3f(1.0f, 0.0f, 0.0f);
-		glBegin(GL_QUADS);
-		glVertex2f(x - size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y + size / 2);
-		glVertex2f(x - size / 2, y + size / 2);
-		glEnd();
-	}
-
-	void foodEffect() const override {
-		points += 1;
-		snakeSpeed -= 5;
-		snake.grow();
-	}
-	~Apple() {}
-};
-
-class Orange : public Food {
-public:
-	void draw() const override {
-		const float size = 30.0f;
-		glColor3f(1.0f, 0.5f, 0.0f);
-		glBegin(GL_QUADS);
-		glVertex2f(x - size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y + size / 2);
-		glVertex2f(x - size / 2, y + size / 2);
-		glEnd();
-	}
-
-	void foodEffect() const override {
-		points += 1;
-		snakeSpeed += 5;
-		snake.grow();
-	}
-	~Orange() {}
-};
-
-class Grape : public Food {
-public:
-	void draw() const override {
-		const float size = 30.0f;
-		glColor3f(0.5f, 0.0f, 1.0f);
-		glBegin(GL_QUADS);
-		glVertex2f(x - size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y + size / 2);
-		glVertex2f(x - size / 2, y + size / 2);
-		glEnd();
-	}
-
-	void foodEffect() const override {
-		snake.grow();
-		points += 5;
-
-	}
-	Grape() {}
-};
-
-
-class Banana : public Food {
-public:
-	void draw() const override {
-		const float size = 30.0f;
-		glColor3f(1.0f, 1.0f, 0.0f);
-		glBegin(GL_QUADS);
-		glVertex2f(x - size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y - size / 2);
-		glVertex2f(x + size / 2, y + size / 2);
-		glVertex2f(x - size / 2, y + size / 2);
-		glEnd();
-	}
-
-	void foodEffect() const override {
-		points += 1;
-		snake.changeColorToRandom();
-		snake.grow();
-	}
-	~Banana() {}
-};
-
-Food* food = nullptr;
-
+void loadSnapshot() {
+	if (!history) {
+		return;
+	}
+	Snapshot snapshot;
+	if (!snapshot.load(snapshotPath) || !snapshot.restore(*game)) {
+		std::cerr << "Cannot load snapshot " << snapshotPath << " onto this board\n";
+		return;
+	}
+	history->clear();
+	history->push(*game);
+	std::cout << "Game loaded from " << snapshotPath << ", tick " << game->getTicks() << "\n";
+}
 
-bool isCollision(int x1, int y1, int x2, int y2) {
-	return x1 == x2 && y1 == y2;
+// Direction keys go through here so they can be recorded with the tick they
+// were pressed on. time is when the key was pressed, for the input latency,
+// 0 for turns the autopilot makes.
+void steer(char direction, std::uint64_t time = 0) {
+	if (playingReplay) {
+		return;
+	}
+	if (arena) {
+		arena->getSnake(0).setDirection(direction, time);
+		return;
+	}
+	if (!recordPath.empty()) {
+		replay.record(static_cast<std::uint64_t>(game->getTicks()), direction);
+	}
+	game->getSnake().setDirection(direction, time);
 }
 
-void checkWallCollision() {
-	//get position of the snakes head.
-	int headX = snake.getSegments().front().x;
-	int headY = snake.getSegments().front().y;
+// Key to move latency of the turn the last tick applied, if it applied one.
+void recordInputLatency(const Snake& snake) {
+	if (snake.getAppliedInputTime() != 0) {
+		SNAKE_PROFILE_VALUE(ProfileMetric::InputLatency, Profiler::now() - snake.getAppliedInputTime());
+	}
+}
 
-	//define game boundaries so the game knows when its out of bounds.
-	int minX = 0;
-	int maxX = 810;
-	int minY = 0;
-	int maxY = 600;
+// The bots, and the autopilot for snake 0, steer with the greedy bot; the
+// Autopilot needs a single snake board.
+void updateArena() {
+	const std::size_t allocationsBefore = allocationCount();
+	const bool wasGameOver = isGameOver();
+	for (std::size_t i = autopilotEnabled ? 0 : 1; i < arena->getSnakeCount(); ++i) {
+		if (arena->isAlive(i)) {
+			arena->getSnake(i).setDirection(greedyDirection(*arena, i));
+		}
+	}
+	arena->update();
+	recordInputLatency(arena->getSnake(0));
+	if (checkAllocs && allocationCount() != allocationsBefore) {
+		std::cerr << "tick " << arena->getTicks() << " allocated " << allocationCount() - allocationsBefore << " times\n";
+	}
 
-	//check if the head position exceeds boundaries.
-	if (headX < minX || headX >= maxX || headY < minY || headY >= maxY) {
-		handleGameOver();
+	if (!wasGameOver && isGameOver()) {
+		std::cout << "Tick jitter:    mean " << timestep.getJitterMeanMs() << " ms, max " << timestep.getJitterMaxMs()
+			<< " ms over " << timestep.getJitterTicks() << " ticks\n";
+		timestep.resetJitter();
 	}
 }
 
-void checkSelfCollision() {
-	// Get the position of the snake's head
-	int headX = snake.getSegments().front().x;
-	int headY = snake.getSegments().front().y;
+// clock is the timestep the ticks run on, the simulation thread's or the
+// arena's.
+void update(FixedTimestep& clock) {
+	SNAKE_PROFILE_SCOPE(ProfileMetric::Tick);
+	if (playingReplay && !replay.apply(*game)) {
+		return; // the recording has ended, hold the last state
+	}
+	if (arena) {
+		updateArena();
+		return;
+	}
 
-	// Store the segments of the snake's body in a local variable
-	const auto& segments = snake.getSegments();
+	const std::size_t allocationsBefore = allocationCount();
+	const bool wasGameOver = game->isGameOver();
+	if (autopilotEnabled && !playingReplay && !wasGameOver) {
+		steer(autopilot.decide(*game));
+	}
+	game->update();
+	if (history && !wasGameOver) {
+		history->push(*game);
+	}
+	recordInputLatency(game->getSnake());
+	if (checkAllocs && allocationCount() != allocationsBefore) {
+		std::cerr << "tick " << game->getTicks() << " allocated " << allocationCount() - allocationsBefore << " times\n";
+	}
 
-	// Iterate through all segments of the snake's body except for the head
-	for (auto it = std::next(segments.begin()); it != segments.end(); ++it) {
-		// Check if the head collides with any other segment of the body
-		if (headX == it->x && headY == it->y) {
-			handleGameOver(); // Trigger game over if self-collision is detected
-			return;
+	if (!wasGameOver && game->isGameOver()) {
+		std::cout << "Tick jitter:    mean " << clock.getJitterMeanMs() << " ms, max " << clock.getJitterMaxMs()
+			<< " ms over " << clock.getJitterTicks() << " ticks\n";
+		clock.resetJitter();
+
+		if (!recordPath.empty()) {
+			replay.finish(*game);
+			if (replay.save(recordPath)) {
+				std::cout << "Replay saved to " << recordPath << "\n";
+			}
+			else {
+				std::cerr << "Cannot write replay " << recordPath << "\n";
+			}
 		}
 	}
 }
 
-void update(int value) {
-
-	if (!gameOver) {
-		snake.move();
-		checkWallCollision(); // added this line to check if the snake hit the wall.
-		checkSelfCollision();
-
-		if (isCollision(snake.getSegments().front().x, snake.getSegments().front().y,
-			food->getX(), food->getY())) {
-			food->foodEffect();
-
-			delete food;
-
-			switch (rand() % 4) {
-			case 0:
-				food = new Apple();
-				food->placeRandom(810, 600);
-				break;
-
-			case 1:
-				food = new Orange();
-				food->placeRandom(810, 600);
-				break;
-			case 2:
-				food = new Grape();
-				food->placeRandom(810, 600);
-				break;
-			case 3:
-				food = new Banana();
-				food->placeRandom(810, 600);
-				break;
-			}
+// Runs the arena ticks that are due on the fixed timestep and redraws at
+// whatever rate the display allows, independent of the tick rate.
+void idle_func(void)
+{
+	if (arena) {
+		const int ticks = timestep.advance(getTickInterval());
+		for (int i = 0; i < ticks; ++i) {
+			update(timestep);
 		}
 	}
-
 	glutPostRedisplay();
-	glutTimerFunc(snakeSpeed, update, 0);
 }
 
 void reshape_func(int width, int height)
 {
+	windowWidth = width;
+	windowHeight = height;
 	glViewport(0, 0, width, height);
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	gluOrtho2D(0, width, 0, height);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
+	renderer.invalidate();
 	glutPostRedisplay();
 }
 
-void restartGame(); // Function prototype declaration
-
-void keyboard_func(unsigned char key, int x, int y)
-{
+// Keys that change the game, on the thread the game ticks on.
+void handleKey(unsigned char key, std::uint64_t pressedAt) {
+	const bool gameOver = arena ? !arena->isAlive(0) : game->isGameOver();
 	if (gameOver) {
 		switch (key)
 		{
 		case 'r': // Restart the game when 'r' key is pressed
 		{
-			restartGame();
+			startGame((arena ? arena->getSeed() : game->getSeed()) + 1);
+			break;
+		}
+
+		case 'z': // Back to before the crash
+		{
+			rewind();
 			break;
 		}
 
-		case 'e': // Exit the game when 'e' key is pressed
+		case 'l':
 		{
-			exit(EXIT_SUCCESS);
+			loadSnapshot();
 			break;
 		}
 		}
@@ -377,121 +349,253 @@ void keyboard_func(unsigned char key, int x, int y)
 		{
 		case 'w':
 		{
-			snake.setDirection('w');
+			steer('w', pressedAt);
 			break;
 		}
 
 		case 'a':
 		{
-			snake.setDirection('a');
+			steer('a', pressedAt);
 			break;
 		}
 
 		case 's':
 		{
-			snake.setDirection('s');
+			steer('s', pressedAt);
 			break;
 		}
 
 		case 'd':
 		{
-			snake.setDirection('d');
+			steer('d', pressedAt);
 			break;
 		}
+
+		case 'p': // Let the autopilot play, or take over again
+		{
+			autopilotEnabled = !autopilotEnabled;
+			break;
+		}
+
+		case 'z': // Rewind a couple of seconds
+		{
+			rewind();
+			break;
 		}
+
+		case 'k': // Save the game, 'l' loads it back
+		{
+			saveSnapshot();
+			break;
+		}
+
+		case 'l':
+		{
+			loadSnapshot();
+			break;
+		}
+		}
+	}
+}
+
+// Keys for the window are handled here, the rest go to the game.
+void keyboard_func(unsigned char key, int x, int y)
+{
+	SNAKE_PROFILE_SCOPE(ProfileMetric::Input);
+	const std::uint64_t pressedAt = Profiler::now();
+#if defined(SNAKE_PROFILING)
+	if (key == 'h') {
+		showProfile = !showProfile;
+	}
+	else if (key == 'j') {
+		writeProfile();
+	}
+#endif
+
+	if (key == 'e' && isGameOver()) { // Exit the game when 'e' key is pressed
+		if (simulation) {
+			simulation->stop(); // joined while the game it ticks is still there
+			simulation.reset();
+		}
+		capture.close();
+		exit(EXIT_SUCCESS);
+	}
+	else if (key == 'b' && !isGameOver()) { // Cycle through batched, incremental and immediate mode rendering
+		const Renderer::Mode mode = renderer.getMode();
+		if (mode == Renderer::Mode::Batched && renderer.canDrawIncrementally()) {
+			renderer.setMode(Renderer::Mode::Incremental);
+		}
+		else {
+			renderer.setMode(mode == Renderer::Mode::Immediate ? Renderer::Mode::Batched : Renderer::Mode::Immediate);
+		}
+		reportRenderMode = true;
+	}
+	else if (simulation) {
+		simulation->post({ static_cast<char>(key), pressedAt });
+	}
+	else {
+		handleKey(key, pressedAt);
 	}
 
 	glutPostRedisplay();
 }
 
+// The arrow keys steer like w, a, s and d.
+void special_func(int key, int x, int y)
+{
+	switch (key)
+	{
+	case GLUT_KEY_UP:
+		keyboard_func('w', x, y);
+		break;
+	case GLUT_KEY_LEFT:
+		keyboard_func('a', x, y);
+		break;
+	case GLUT_KEY_DOWN:
+		keyboard_func('s', x, y);
+		break;
+	case GLUT_KEY_RIGHT:
+		keyboard_func('d', x, y);
+		break;
+	}
+}
+
 //=================================================================================================
 // RENDERING
 //=================================================================================================
 
-void restartGame() {
-	// Reset game state
-	gameOver = false;
-	points = 0;
-
-}
+// Laid out once in init(), or again when the score or speed they show
+// changes, never per frame.
+TextRenderer::Label gameOverLabel, restartLabel;
+TextRenderer::Label scoreLabel;
+int scoreLabelPoints = -1;
+TextRenderer::Label hudLabel;
+int hudPoints = -1, hudInterval = -1, hudWindowWidth = -1, hudWindowHeight = -1;
 
 void renderGameOverScreen() {
-
-	// Render game over message
-	glColor3f(1.0f, 0.0f, 0.0f);
-	glRasterPos2i(330, 390);
-	std::string gameOverMessage = "Game Over!";
-	for (const char& c : gameOverMessage) {
-		glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, c);
+	if (getPoints() != scoreLabelPoints) {
+		scoreLabelPoints = getPoints();
+		char text[32];
+		std::snprintf(text, sizeof(text), "Score: %d", scoreLabelPoints);
+		largeText.layout(scoreLabel, text, 350, 328, 1.0f, 1.0f, 1.0f);
 	}
+	const TextRenderer::Label* labels[] = { &gameOverLabel, &scoreLabel, &restartLabel };
+	largeText.draw(labels, 3);
+}
 
-	// Render score
-	glColor3f(1.0f, 1.0f, 1.0f);
-	glRasterPos2i(350, 328);
-	std::string scoreMessage = "Score: " + std::to_string(points);
-	for (const char& c : scoreMessage) {
-		glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, c);
+// Score and speed in the top right corner while playing, one draw call.
+void renderHud() {
+	if (getPoints() != hudPoints || getTickInterval() != hudInterval || windowWidth != hudWindowWidth
+		|| windowHeight != hudWindowHeight) {
+		hudPoints = getPoints();
+		hudInterval = getTickInterval();
+		hudWindowWidth = windowWidth;
+		hudWindowHeight = windowHeight;
+		char text[48];
+		std::snprintf(text, sizeof(text), "Score %d  Speed %.1f/s", hudPoints, 1000.0 / hudInterval);
+		const int width = smallText.measure(text);
+		smallText.layout(hudLabel, text, windowWidth - width - 6, windowHeight - smallText.getHeight() - 2, 1.0f, 1.0f, 1.0f);
 	}
+	smallText.draw(hudLabel);
+}
 
-	// Render restart text
-	glColor3f(0.0f, 0.0f, 1.0f);
-	glRasterPos2i(248, 270);
-	std::string restartMessage = "Press R to Restart or E to exit";
-	for (const char& c : restartMessage) {
-		glutBitmapCharacter(GLUT_BITMAP_TIMES_ROMAN_24, c);
+#if defined(SNAKE_PROFILING)
+// The histograms as text in the top left corner, on a dark panel.
+void renderProfile() {
+	static const ProfileMetric times[] = { ProfileMetric::Tick, ProfileMetric::Frame, ProfileMetric::Input, ProfileMetric::InputLatency };
+	static const char* names[] = { "tick", "frame", "input", "latency" };
+	const int top = windowHeight;
+	const int lineHeight = 15;
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
+	glBegin(GL_QUADS);
+	glVertex2i(0, top);
+	glVertex2i(330, top);
+	glVertex2i(330, top - 6 * lineHeight - 8);
+	glVertex2i(0, top - 6 * lineHeight - 8);
+	glEnd();
+	glDisable(GL_BLEND);
+
+	// Fixed buffers and labels, the overlay must not allocate while it is up.
+	static TextRenderer::Label lines[5] = { TextRenderer::Label(96), TextRenderer::Label(96), TextRenderer::Label(96),
+		TextRenderer::Label(96), TextRenderer::Label(96) };
+	const TextRenderer::Label* labels[5];
+	char line[96];
+	for (int i = 0; i < 5; ++i) {
+		if (i < 4) {
+			const Histogram& h = Profiler::histogram(times[i]);
+			std::snprintf(line, sizeof(line), "%-8s p50 %7.3f  p99 %7.3f  max %7.3f ms", names[i], h.percentile(50.0) / 1e6,
+				h.percentile(99.0) / 1e6, h.getMax() / 1e6);
+		}
+		else {
+			const Histogram& h = Profiler::histogram(ProfileMetric::DrawCalls);
+			std::snprintf(line, sizeof(line), "%-8s p50 %7llu  max %7llu", "draws", static_cast<unsigned long long>(h.percentile(50.0)),
+				static_cast<unsigned long long>(h.getMax()));
+		}
+		smallText.layout(lines[i], line, 6, top - (i + 1) * lineHeight, 1.0f, 1.0f, 1.0f);
+		labels[i] = &lines[i];
 	}
+	smallText.draw(labels, 5);
 }
-
+#endif
 
 void display_func(void)
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glLoadIdentity();
-
-	if (!gameOver) {
-		// grid
-		glColor3f(0.0f, 0.0f, 0.0f);
-
-		const float lineWidth = 2.0f;
-
-		for (int x = 0; x <= 810; x += segmentSize) {
-			glLineWidth(lineWidth);
-			glBegin(GL_LINES);
-			glVertex2f(static_cast<float>(x), 0.0f);
-			glVertex2f(static_cast<float>(x), 600.0f);
-			glEnd();
-
+	const std::size_t allocationsBefore = allocationCount();
+	{
+		SNAKE_PROFILE_SCOPE(ProfileMetric::Frame);
+		if (simulation && simulation->acquire()) {
+			simulation->getFrame().state.restore(*view);
 		}
-		for (int y = 0; y <= 600; y += segmentSize) {
-			glLineWidth(lineWidth);
-			glBegin(GL_LINES);
-			glVertex2f(0.0f, static_cast<float>(y));
-			glVertex2f(810.0f, static_cast<float>(y));
-			glEnd();
-
+		// Incremental mode copies the whole playfield over the window.
+		const bool incremental = renderer.getMode() == Renderer::Mode::Incremental;
+		if (!incremental || isGameOver()) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		}
-		//draw snake
-		const float size = 30.0f;
-		glColor3f(snake.getRed(), snake.getGreen(), snake.getBlue()); //snake color (change)
-		for (const auto& segment : snake.getSegments()) {
-			glBegin(GL_QUADS);
-			glVertex2f(segment.x - size / 2, segment.y - size / 2);
-			glVertex2f(segment.x + size / 2, segment.y - size / 2);
-			glVertex2f(segment.x + size / 2, segment.y + size / 2);
-			glVertex2f(segment.x - size / 2, segment.y + size / 2);
-			glEnd();
+		glLoadIdentity();
+
+		if (!isGameOver()) {
+			// which draws every segment on its cell, so the view follows it there
+			const float alpha = incremental ? 1.0f
+				: arena ? timestep.getAlpha() : simulation->getAlpha(SimulationThread::Clock::now());
+			if (arena) {
+				renderer.drawArena(*arena, alpha,
+					Renderer::followHead(arena->getSnake(0), arena->getColumns(), arena->getRows(), alpha, windowWidth, windowHeight));
+			}
+			else {
+				renderer.drawPlayfield(*view, alpha, Renderer::followHead(*view, alpha, windowWidth, windowHeight));
+			}
+			renderHud();
+			SNAKE_PROFILE_VALUE(ProfileMetric::DrawCalls, renderer.getDrawCalls() + smallText.getDrawCalls());
 		}
-	}
-	else {
-		// Render the game over screen
-		renderGameOverScreen();
+		else {
+			// Render the game over screen, over which the next game's
+			// playfield is drawn from scratch
+			renderGameOverScreen();
+			renderer.invalidate();
+		}
+#if defined(SNAKE_PROFILING)
+		if (showProfile) {
+			renderProfile();
+		}
+#endif
 	}
 
+	// Text is laid out into labels that keep their storage, so the game over
+	// screen is allocation free as well.
+	if (checkAllocs && allocationCount() != allocationsBefore) {
+		std::cerr << "frame allocated " << allocationCount() - allocationsBefore << " times\n";
+	}
 
-	if (!gameOver && food) {
-		food->draw();
+	if (reportRenderMode && !isGameOver()) {
+		std::cout << "Rendering:      " << Renderer::getModeName(renderer.getMode())
+			<< ", " << renderer.getDrawCalls() << " draw calls per frame\n";
+		reportRenderMode = false;
 	}
 
+	capture.capture();
 	glutSwapBuffers();
 }
 
@@ -509,27 +613,23 @@ void init(void)
 	// Set the background color (red, green, blue, alpha)
 	glClearColor(0.3f, 0.5f, 0.2f, 0.5f);
 
-	if (food) {
-		delete food;
+	if (!renderer.init(getProcAddress)) {
+		std::cout << "Buffer objects unavailable, using immediate mode rendering\n";
 	}
+	renderer.setMode(startMode);
 
-	switch (rand() % 4) {
-	case 0:
-		food = new Apple();
-		food->placeRandom(810, 600);
-		break;
-	case 1:
-		food = new Orange();
-		food->placeRandom(810, 600);
-		break;
-	case 2:
-		food = new Grape();
-		food->placeRandom(810, 600);
-		break;
-	case 3:
-		food = new Banana();
-		food->placeRandom(810, 600);
-		break;
+	const BitmapFont timesRoman = { drawGlutCharacter, glutCharacterWidth, GLUT_BITMAP_TIMES_ROMAN_24,
+		glutBitmapHeight(GLUT_BITMAP_TIMES_ROMAN_24) };
+	const BitmapFont fixed = { drawGlutCharacter, glutCharacterWidth, GLUT_BITMAP_8_BY_13, glutBitmapHeight(GLUT_BITMAP_8_BY_13) };
+	if (!largeText.init(getProcAddress, timesRoman) || !smallText.init(getProcAddress, fixed)) {
+		std::cout << "Framebuffer objects unavailable, drawing text one character at a time\n";
+	}
+	largeText.layout(gameOverLabel, "Game Over!", 330, 390, 1.0f, 0.0f, 0.0f);
+	largeText.layout(restartLabel, "Press R to Restart or E to exit", 248, 270, 0.0f, 0.0f, 1.0f);
+
+	if (!capturePath.empty() && capture.open(getProcAddress, capturePath, FrameCapture::formatFor(capturePath),
+		glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT), 60)) {
+		std::cerr << "Capturing to " << capturePath << (capture.isAsync() ? "" : ", reading every frame back on the spot") << "\n";
 	}
 
 	std::cout << "Finished initializing...\n\n";
@@ -543,8 +643,110 @@ int main(int argc, char** argv)
 {
 	glutInit(&argc, argv);
 
+	std::uint64_t seed = static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+	int columns = Game::defaultColumns;
+	int rows = Game::defaultRows;
+	int arenaSnakes = 0;
+	int arenaFoods = 4;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--check-allocs") {
+			checkAllocs = true;
+		}
+		else if (arg == "--immediate") {
+			startMode = Renderer::Mode::Immediate;
+		}
+		else if (arg == "--incremental") {
+			startMode = Renderer::Mode::Incremental;
+		}
+		else if (arg == "--autopilot") {
+			autopilotEnabled = true;
+		}
+#if defined(SNAKE_PROFILING)
+		else if (arg == "--profile" && hasValue) {
+			profilePath = argv[++i];
+		}
+#endif
+		else if (arg == "--columns" && hasValue) {
+			columns = std::atoi(argv[++i]);
+		}
+		else if (arg == "--rows" && hasValue) {
+			rows = std::atoi(argv[++i]);
+		}
+		else if (arg == "--arena" && hasValue) {
+			arenaSnakes = std::atoi(argv[++i]);
+		}
+		else if (arg == "--foods" && hasValue) {
+			arenaFoods = std::atoi(argv[++i]);
+		}
+		else if (arg == "--seed" && hasValue) {
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--snapshot" && hasValue) {
+			snapshotPath = argv[++i];
+		}
+		else if (arg == "--capture" && hasValue && std::string(argv[i + 1]) != "-") {
+			capturePath = argv[++i];
+		}
+		else if (arg == "--record" && hasValue) {
+			recordPath = argv[++i];
+		}
+		else if (arg == "--replay" && hasValue) {
+			if (!replay.load(argv[++i])) {
+				std::cerr << "Cannot read replay " << argv[i] << "\n";
+				return EXIT_FAILURE;
+			}
+			playingReplay = true;
+		}
+	}
+	if (playingReplay) {
+		// A replay only plays back on the board it was recorded on.
+		columns = replay.getColumns();
+		rows = replay.getRows();
+	}
+	if (columns < 1 || columns > Game::maxBoardSize || rows < 1 || rows > Game::maxBoardSize) {
+		std::cerr << "Board size must be 1 to " << Game::maxBoardSize << " cells on each side\n";
+		return EXIT_FAILURE;
+	}
+	if (arenaSnakes != 0) {
+		if (playingReplay || !recordPath.empty()) {
+			std::cerr << "Replays record single snake games only\n";
+			return EXIT_FAILURE;
+		}
+		// One start row per snake, see Arena.
+		if (arenaSnakes < 1 || arenaSnakes > rows || arenaFoods < 1) {
+			std::cerr << "--arena takes 1 to " << rows << " snakes and --foods at least 1\n";
+			return EXIT_FAILURE;
+		}
+		arena.reset(new Arena(columns, rows, arenaSnakes, arenaFoods));
+		startGame(seed);
+	}
+	else {
+		game.reset(new Game(columns, rows));
+		if (!playingReplay && recordPath.empty()) {
+			const std::size_t ticks = std::min(historyTicks, historyBytes / Snapshot::maxSize(columns, rows));
+			history.reset(new SnapshotRing(std::max(ticks, std::size_t(1)), columns, rows));
+		}
+		startGame(seed);
+		autopilot.decide(*game); // sizes its bitboards before the first tick
+
+		view.reset(new Game(columns, rows, 1, false));
+		simulation.reset(new SimulationThread(*game,
+			[](Game&, const SimulationThread::Command& command) { handleKey(static_cast<unsigned char>(command.key), command.time); },
+			[](Game&, FixedTimestep& clock) {
+				update(clock);
+				return true;
+			}));
+	}
+#if defined(SNAKE_PROFILING)
+	std::atexit(writeProfile);
+#endif
+
 	glutInitWindowPosition(100, 100);
-	glutInitWindowSize(810, 600);
+	// The whole board if it fits in the default window, the default window otherwise.
+	glutInitWindowSize(std::min(columns, static_cast<int>(Game::defaultColumns)) * segmentSize,
+		std::min(rows, static_cast<int>(Game::defaultRows)) * segmentSize);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
 
 	glutCreateWindow("Snake");
@@ -552,10 +754,14 @@ int main(int argc, char** argv)
 	glutDisplayFunc(display_func);
 	glutReshapeFunc(reshape_func);
 	glutKeyboardFunc(keyboard_func);
+	glutSpecialFunc(special_func);
 
 	init();
 
-	glutTimerFunc(snakeSpeed, update, 0);
+	if (simulation) {
+		simulation->start();
+	}
+	glutIdleFunc(idle_func);
 	glutMainLoop();
 
 	return EXIT_SUCCESS;
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "Bot.h"
+#include "FrameCapture.h"
+#include "Game.h"
+#include "OffscreenContext.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "TextRenderer.h"
+
+//=================================================================================================
+// OFFSCREEN RENDERER
+//=================================================================================================
+
+// Plays bot games and renders every tick into an offscreen software context,
+// reporting frame time and draw calls per frame.
+//
+//   snake_offscreen [--frames N] [--seed N] [--columns N] [--rows N] [--arena SNAKES] [--replay FILE] [--immediate | --incremental] [--text] [--verify]
+//                   [--capture FILE] [--format ppm|y4m] [--fps N] [--sync-capture]
+//
+// --verify renders each frame with both the batched and the immediate path
+// and fails if the pixels differ; with --incremental, incrementally and
+// with the immediate path. Boards larger than the default window are
+// drawn through a default sized window that follows the head. --arena plays
+// an arena of greedy bots with four pieces of food instead, following snake 0
+// while it is in. --text draws a score and speed HUD over every frame from
+// the glyph atlas; with --verify, also one character at a time through the
+// font, which must give the same pixels. There is no GLUT here, the font is
+// a made up one drawn with glBitmap like GLUT's.
+//
+// --replay plays a recorded game to its end instead of bot games. --capture
+// streams every frame to FILE, "-" for standard output, through a
+// FrameCapture, as --fps frames a second (default 30) of Y4M for a .y4m file
+// or --format y4m, and PPM images otherwise; the report then goes to
+// standard error. --sync-capture reads each frame back before going on, for
+// comparison with the default pixel buffer readback. E.g.
+//
+//   snake_offscreen --replay game.snkr --capture - --format y4m | ffmpeg -i - game.mp4
+
+namespace {
+
+struct Options {
+	int frames = 2000;
+	unsigned seed = 1;
+	int columns = Game::defaultColumns;
+	int rows = Game::defaultRows;
+	int arenaSnakes = 0;
+	bool immediate = false;
+	bool incremental = false;
+	bool text = false;
+	bool verify = false;
+	std::string replayPath;
+	std::string capturePath;
+	FrameCapture::Format captureFormat = FrameCapture::Format::Ppm;
+	bool captureFormatSet = false;
+	int fps = 30;
+	bool syncCapture = false;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+			options.frames = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+			options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--columns") == 0 && hasValue) {
+			options.columns = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--rows") == 0 && hasValue) {
+			options.rows = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--arena") == 0 && hasValue) {
+			options.arenaSnakes = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--immediate") == 0) {
+			options.immediate = true;
+		}
+		else if (std::strcmp(argv[i], "--incremental") == 0) {
+			options.incremental = true;
+		}
+		else if (std::strcmp(argv[i], "--text") == 0) {
+			options.text = true;
+		}
+		else if (std::strcmp(argv[i], "--verify") == 0) {
+			options.verify = true;
+		}
+		else if (std::strcmp(argv[i], "--replay") == 0 && hasValue) {
+			options.replayPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--capture") == 0 && hasValue) {
+			options.capturePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--format") == 0 && hasValue && FrameCapture::parseFormat(argv[i + 1], options.captureFormat)) {
+			options.captureFormatSet = true;
+			++i;
+		}
+		else if (std::strcmp(argv[i], "--fps") == 0 && hasValue) {
+			options.fps = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--sync-capture") == 0) {
+			options.syncCapture = true;
+		}
+		else {
+			std::cerr << "usage: " << argv[0] << " [--frames N] [--seed N] [--columns N] [--rows N] [--arena SNAKES] [--replay FILE] [--immediate | --incremental] [--text] [--verify]\n"
+				<< "       [--capture FILE] [--format ppm|y4m] [--fps N] [--sync-capture]\n";
+			return false;
+		}
+	}
+	if (options.columns < 1 || options.columns > Game::maxBoardSize || options.rows < 1 || options.rows > Game::maxBoardSize) {
+		std::cerr << "Board size must be 1 to " << Game::maxBoardSize << " cells on each side\n";
+		return false;
+	}
+	if (options.arenaSnakes < 0 || options.arenaSnakes > options.rows) {
+		std::cerr << "An arena has 1 to " << options.rows << " snakes\n";
+		return false;
+	}
+	if (!options.replayPath.empty() && options.arenaSnakes > 0) {
+		std::cerr << "Replays record single snake games only\n";
+		return false;
+	}
+	if (!options.captureFormatSet) {
+		options.captureFormat = FrameCapture::formatFor(options.capturePath);
+	}
+	return true;
+}
+
+// Incremental mode copies the whole view over the frame, there is nothing to clear.
+void clearFrame(const Renderer& renderer) {
+	if (renderer.getMode() != Renderer::Mode::Incremental) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+}
+
+void renderFrame(Renderer& renderer, const Game& game, int width, int height) {
+	clearFrame(renderer);
+	renderer.drawPlayfield(game, 1.0f, Renderer::followHead(game, 1.0f, width, height));
+}
+
+void renderFrame(Renderer& renderer, const Arena& arena, int width, int height) {
+	clearFrame(renderer);
+	renderer.drawArena(arena, 1.0f, Renderer::followHead(arena.getSnake(0), arena.getColumns(), arena.getRows(), 1.0f, width, height));
+}
+
+void renderFrame(Renderer& renderer, const Game& game, const Arena* arena, int width, int height) {
+	if (arena) {
+		renderFrame(renderer, *arena, width, height);
+	}
+	else {
+		renderFrame(renderer, game, width, height);
+	}
+}
+
+// An 8 x 13 font with every glyph a different pattern of bits, descending
+// 3 pixels below the baseline, advancing 9.
+const int testFontHeight = 13;
+
+void drawTestCharacter(void*, int character) {
+	GLubyte rows[testFontHeight] = {};
+	if (character != ' ') {
+		for (int row = 0; row < testFontHeight; ++row) {
+			rows[row] = static_cast<GLubyte>(character * 37 + row * 11) ^ static_cast<GLubyte>(character << (row % 3));
+		}
+	}
+	glBitmap(8, testFontHeight, 0.0f, 3.0f, 9.0f, 0.0f, rows);
+}
+
+int testCharacterWidth(void*, int) {
+	return 9;
+}
+
+void layoutHud(const TextRenderer& text, TextRenderer::Label& label, int points, int interval, int width, int height) {
+	char line[48];
+	std::snprintf(line, sizeof(line), "Score %d  Speed %.1f/s", points, 1000.0 / interval);
+	text.layout(label, line, width - text.measure(line) - 6, height - text.getHeight() - 2, 1.0f, 1.0f, 1.0f);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return EXIT_FAILURE;
+	}
+	Replay replay;
+	const bool playingReplay = !options.replayPath.empty();
+	if (playingReplay) {
+		if (!replay.load(options.replayPath)) {
+			std::cerr << "Cannot read replay " << options.replayPath << "\n";
+			return EXIT_FAILURE;
+		}
+		// A replay only plays back on the board it was recorded on.
+		options.columns = replay.getColumns();
+		options.rows = replay.getRows();
+		if (options.columns < 1 || options.columns > Game::maxBoardSize || options.rows < 1
+			|| options.rows > Game::maxBoardSize) {
+			std::cerr << "Board size must be 1 to " << Game::maxBoardSize << " cells on each side\n";
+			return EXIT_FAILURE;
+		}
+	}
+	// Standard output may be the video.
+	std::ostream& report = options.capturePath == "-" ? std::cerr : std::cout;
+
+	Game game(options.columns, options.rows, options.seed);
+	if (playingReplay) {
+		game.newGame(replay.getSeed());
+	}
+	std::unique_ptr<Arena> arena;
+	if (options.arenaSnakes > 0) {
+		arena.reset(new Arena(options.columns, options.rows, options.arenaSnakes, 4, options.seed));
+	}
+	const int width = std::min(options.columns, static_cast<int>(Game::defaultColumns)) * Renderer::segmentSize;
+	const int height = std::min(options.rows, static_cast<int>(Game::defaultRows)) * Renderer::segmentSize;
+	OffscreenContext context;
+	if (!context.create(width, height)) {
+		return EXIT_FAILURE;
+	}
+	report << "Renderer:       " << glGetString(GL_RENDERER) << "\n";
+	report << "OpenGL Version: " << glGetString(GL_VERSION) << "\n";
+
+	glClearColor(0.3f, 0.5f, 0.2f, 0.5f);
+
+	Renderer renderer;
+	renderer.init(OffscreenContext::getProcAddress);
+	if (options.immediate) {
+		renderer.setMode(Renderer::Mode::Immediate);
+	}
+	else if (options.incremental) {
+		renderer.setMode(Renderer::Mode::Incremental);
+	}
+	const Renderer::Mode mode = renderer.getMode();
+	const Renderer::Mode reference = mode == Renderer::Mode::Immediate ? Renderer::Mode::Batched : Renderer::Mode::Immediate;
+
+	TextRenderer text;
+	TextRenderer::Label hud;
+	int hudPoints = -1, hudInterval = -1;
+	bool textAtlas = false;
+	if (options.text) {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		textAtlas = text.init(OffscreenContext::getProcAddress, BitmapFont{ drawTestCharacter, testCharacterWidth, nullptr, testFontHeight });
+		if (!textAtlas) {
+			report << "Framebuffer objects unavailable, drawing text one character at a time\n";
+		}
+	}
+
+	FrameCapture capture;
+	if (!options.capturePath.empty()
+		&& !capture.open(OffscreenContext::getProcAddress, options.capturePath, options.captureFormat, width, height, options.fps, !options.syncCapture)) {
+		return EXIT_FAILURE;
+	}
+
+	std::vector<unsigned char> expected, actual;
+	long long drawCalls = 0;
+	long long repaintedCells = 0;
+	int mismatches = 0;
+	double renderSeconds = 0.0;
+	int frames = 0;
+	const auto loopStart = std::chrono::steady_clock::now();
+
+	for (; playingReplay || frames < options.frames; ++frames) {
+		if (playingReplay) {
+			if (!replay.apply(game)) {
+				break;
+			}
+			game.update();
+		}
+		else if (arena) {
+			for (std::size_t i = 0; i < arena->getSnakeCount(); ++i) {
+				if (arena->isAlive(i)) {
+					arena->getSnake(i).setDirection(greedyDirection(*arena, i));
+				}
+			}
+			arena->update();
+			if (!arena->isAlive(0)) {
+				arena->newGame(arena->getSeed() + 1);
+			}
+		}
+		else {
+			game.getSnake().setDirection(greedyDirection(game));
+			game.update();
+			if (game.isGameOver()) {
+				game.newGame(game.getSeed() + 1);
+			}
+		}
+
+		const int points = arena ? arena->getSnake(0).getPoints() : game.getPoints();
+		const int interval = arena ? arena->getTickInterval() : game.getTickInterval();
+		if (options.text && (points != hudPoints || interval != hudInterval)) {
+			hudPoints = points;
+			hudInterval = interval;
+			layoutHud(text, hud, points, interval, width, height);
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		renderFrame(renderer, game, arena.get(), width, height);
+		if (options.text) {
+			text.draw(hud);
+		}
+		glFinish();
+		renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		drawCalls += renderer.getDrawCalls() + (options.text ? text.getDrawCalls() : 0);
+		repaintedCells += renderer.getRepaintedCells();
+		capture.capture();
+
+		if (options.verify) {
+			context.readPixels(actual);
+			renderer.setMode(reference);
+			text.setAtlasEnabled(false);
+			renderFrame(renderer, game, arena.get(), width, height);
+			if (options.text) {
+				text.draw(hud);
+			}
+			context.readPixels(expected);
+			renderer.setMode(mode);
+			text.setAtlasEnabled(true);
+			if (expected != actual) {
+				++mismatches;
+			}
+		}
+	}
+
+	const bool captured = capture.close();
+	const double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+	renderer.release();
+	text.release();
+
+	const double frameCount = frames > 0 ? frames : 1;
+	report << "mode:           " << Renderer::getModeName(mode) << "\n";
+	report << "frames:         " << frames << "\n";
+	report << "ms/frame:       " << renderSeconds * 1000.0 / frameCount << "\n";
+	report << "draw calls:     " << drawCalls / frameCount << " per frame\n";
+	if (mode == Renderer::Mode::Incremental) {
+		report << "repainted:      " << repaintedCells / frameCount << " cells per frame\n";
+	}
+	if (options.text) {
+		report << "text:           " << (textAtlas ? "glyph atlas" : "per character") << "\n";
+	}
+	if (playingReplay) {
+		const bool same = static_cast<std::uint64_t>(game.getTicks()) == replay.getEndTick() && game.stateHash() == replay.getEndHash();
+		report << "replay:         " << (same ? "ended as recorded" : "ENDED DIFFERENTLY") << "\n";
+	}
+	if (!options.capturePath.empty()) {
+		// Throughput of the whole loop, simulation and rendering included,
+		// and of capturing alone.
+		report << "capture:        " << capture.getFrames() << " frames, " << capture.getBytes() / (1024.0 * 1024.0) << " MB, "
+			<< (capture.isAsync() ? "pixel buffer" : "synchronous") << " readback\n";
+		report << "capture fps:    " << capture.getFrames() / loopSeconds << " overall, "
+			<< capture.getSeconds() * 1000.0 / frameCount << " ms/frame capturing\n";
+		if (!captured || capture.getFrames() != frames) {
+			std::cerr << "error: cannot write every frame to " << options.capturePath << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (options.verify) {
+		report << "mismatches:     " << mismatches << "\n";
+		if (mismatches != 0) {
+			std::cerr << "error: " << Renderer::getModeName(mode) << " and " << Renderer::getModeName(reference) << " rendering differ on "
+				<< mismatches << " frames\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}